@@ -0,0 +1,167 @@
+// Micro-benchmark of how Element stores its children, comparing the old
+// std::unique_ptr<Element, std::function<void(Element*)>> with the current ElementPtr
+// (a unique_ptr with a stateless deleter). It mirrors the ownership and deleter
+// logic of Element (including the ElementArena branch) without needing SDL, so it
+// can be built anywhere:
+//
+//   g++ -O2 -std=c++17 -Isrc bench/child_storage.cpp src/ElementArena.cpp -o child_storage && ./child_storage
+
+#include "ElementArena.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#define FANOUT 8
+#define DEPTH 5
+#define ROUNDS 20
+
+template<typename Ptr>
+struct Node
+{
+	virtual ~Node() = default;
+	std::vector<Ptr> elements;
+	bool isProtected = false;
+	Chesto::ElementArena* arena = nullptr;
+	int x = 0, y = 0, xAbs = 0, yAbs = 0;
+};
+
+// the old child pointer: every one carries its own type-erased deleter
+struct OldNode;
+typedef std::unique_ptr<OldNode, std::function<void(OldNode*)>> OldPtr;
+struct OldNode : Node<OldPtr> {};
+
+// the same as ElementDeleter, but called through the std::function
+static void oldDeleter(OldNode* node)
+{
+	if (node && !node->isProtected)
+	{
+		if (node->arena)
+		{
+			Chesto::ElementArena* arena = node->arena;
+			void* memory = dynamic_cast<void*>(node);
+			node->~OldNode();
+			arena->release(memory);
+		}
+		else
+			delete node;
+	}
+}
+
+static OldPtr makeOld()
+{
+	return OldPtr(new OldNode(), oldDeleter);
+}
+
+// the new child pointer: the deleter is an empty struct, so it's just a pointer
+struct NewNode;
+struct NewDeleter
+{
+	void operator()(NewNode* node) const;
+};
+typedef std::unique_ptr<NewNode, NewDeleter> NewPtr;
+struct NewNode : Node<NewPtr> {};
+
+// the same as ElementDeleter
+void NewDeleter::operator()(NewNode* node) const
+{
+	if (node && !node->isProtected)
+	{
+		if (node->arena)
+		{
+			Chesto::ElementArena* arena = node->arena;
+			void* memory = dynamic_cast<void*>(node);
+			node->~NewNode();
+			arena->release(memory);
+		}
+		else
+			delete node;
+	}
+}
+
+static NewPtr makeNew()
+{
+	return NewPtr(new NewNode());
+}
+
+// like createNode in a Screen with useArena set
+static Chesto::ElementArena* benchArena = nullptr;
+static NewPtr makeNewInArena()
+{
+	return NewPtr(benchArena->create<NewNode>());
+}
+
+template<typename T, typename Ptr>
+static void build(T* node, int depth, Ptr (*make)())
+{
+	if (depth == 0)
+		return;
+
+	for (int i = 0; i < FANOUT; i++)
+	{
+		node->elements.push_back(make());
+		node->elements.back()->x = i;
+		build(node->elements.back().get(), depth - 1, make);
+	}
+}
+
+// like recalcPosition over the whole tree
+template<typename T>
+static long traverse(T* node, int parentX, int parentY)
+{
+	node->xAbs = parentX + node->x;
+	node->yAbs = parentY + node->y;
+
+	long visited = 1;
+	for (auto& child : node->elements)
+		visited += traverse(child.get(), node->xAbs, node->yAbs);
+	return visited;
+}
+
+static double now()
+{
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+template<typename T, typename Ptr>
+static void run(const char* name, Ptr (*make)())
+{
+	double buildTime = 0, traverseTime = 0, teardownTime = 0;
+	long nodes = 0;
+
+	for (int round = 0; round < ROUNDS; round++)
+	{
+		double start = now();
+		Ptr root = make();
+		build(root.get(), DEPTH, make);
+		double built = now();
+
+		for (int i = 0; i < 10; i++)
+			nodes = traverse(root.get(), 0, 0);
+		double traversed = now();
+
+		root.reset();
+		double tornDown = now();
+
+		buildTime += built - start;
+		traverseTime += (traversed - built) / 10;
+		teardownTime += tornDown - traversed;
+	}
+
+	printf("%-10s %3zu bytes/child  %ld nodes  build %7.3f ms  traverse %7.3f ms  teardown %7.3f ms\n",
+		name, sizeof(Ptr), nodes, buildTime / ROUNDS, traverseTime / ROUNDS, teardownTime / ROUNDS);
+}
+
+int main()
+{
+	run<OldNode, OldPtr>("function", makeOld);
+	run<NewNode, NewPtr>("ElementPtr", makeNew);
+
+	Chesto::ElementArena arena;
+	benchArena = &arena;
+	run<NewNode, NewPtr>("arena", makeNewInArena);
+	return 0;
+}
@@ -0,0 +1,277 @@
+// Runs the synthetic scenarios from Scenarios.cpp on a headless display with a virtual 60Hz clock,
+// and prints the results as JSON. Built with `make bench` from an app (see the README), and run from
+// a directory with resin/res/fonts in it:
+//
+//   ./app_bench.bin [--frames N] [--warmup N] [--window] [--partial] [--retained] [--batch] [--cull] [--layout] [--focus] [scenario...]
+
+#include "Clock.hpp"
+#include "RootDisplay.hpp"
+#include "Scenarios.hpp"
+#include "Screen.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace Chesto;
+
+// every allocation made through new, so they can be counted per frame
+static std::atomic<long> allocations(0);
+
+void* operator new(std::size_t size)
+{
+	allocations++;
+	void* ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	free(ptr);
+}
+
+// the most memory the process has used so far (across every scenario), in KB
+static long processPeakRSS()
+{
+#ifdef _WIN32
+	return 0;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024; // in bytes on macOS
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// start measuring the peak RSS from the current usage, returns false if the OS can't (only Linux can)
+static bool resetPeakRSS()
+{
+#ifdef __linux__
+	FILE* file = fopen("/proc/self/clear_refs", "w");
+	if (!file)
+		return false;
+	bool reset = fputs("5", file) >= 0;
+	return fclose(file) == 0 && reset;
+#else
+	return false;
+#endif
+}
+
+// the most memory used since resetPeakRSS, in KB
+static long peakRSSSinceReset()
+{
+	long peak = 0;
+#ifdef __linux__
+	FILE* file = fopen("/proc/self/status", "r");
+	if (!file)
+		return 0;
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		if (sscanf(line, "VmHWM: %ld kB", &peak) == 1)
+			break;
+	}
+	fclose(file);
+#endif
+	return peak;
+}
+
+// quote a string for the JSON output
+static std::string jsonString(const std::string& text)
+{
+	std::string quoted = "\"";
+	for (unsigned char c : text)
+	{
+		if (c == '"' || c == '\\')
+			quoted += std::string("\\") + (char)c;
+		else if (c == '\n')
+			quoted += "\\n";
+		else if (c < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			quoted += escaped;
+		}
+		else
+			quoted += c;
+	}
+	return quoted + "\"";
+}
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty())
+		return 0;
+	return sorted[(size_t)(p / 100 * (sorted.size() - 1) + 0.5)];
+}
+
+int main(int argc, char* argv[])
+{
+	int frames = 600;
+	int warmup = 60;
+	bool window = false;
+	std::vector<std::string> flags;
+	std::vector<std::string> only;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--frames" && i + 1 < argc)
+			frames = std::max(atoi(argv[++i]), 1);
+		else if (arg == "--warmup" && i + 1 < argc)
+			warmup = std::max(atoi(argv[++i]), 0);
+		else if (arg == "--window")
+			window = true;
+		else if (arg.rfind("--", 0) == 0)
+			flags.push_back(arg.substr(2));
+		else
+			only.push_back(arg);
+	}
+
+	// rendering options to compare, applied before anything is drawn
+	for (auto& flag : flags)
+	{
+		if (flag == "partial")
+			RootDisplay::partialRedraw = true;
+		else if (flag == "retained")
+			RootDisplay::retainedRender = true;
+		else if (flag == "batch")
+			RootDisplay::batchRendering = true;
+		else if (flag == "cull")
+			RootDisplay::cullSubtrees = true;
+		else if (flag == "layout")
+			RootDisplay::cacheLayout = true;
+		else if (flag == "focus")
+			RootDisplay::focusDispatch = true;
+		else
+		{
+			fprintf(stderr, "Unknown option: --%s\n", flag.c_str());
+			return 1;
+		}
+	}
+
+	std::vector<Scenario> scenarios;
+	for (auto& scenario : getScenarios())
+	{
+		if (only.empty() || std::find(only.begin(), only.end(), scenario.name) != only.end())
+			scenarios.push_back(scenario);
+	}
+
+	if (scenarios.empty())
+	{
+		fprintf(stderr, "No matching scenarios\n");
+		return 1;
+	}
+
+	RootDisplay::headless = !window;
+
+	// every run sees exactly the same (simulated) time, so animations and scrolling are repeatable
+	VirtualClock clock;
+	Clock::set(&clock);
+
+	auto display = std::make_unique<RootDisplay>();
+
+	printf("{\n");
+#ifdef APP_VERSION
+	printf("  \"version\": \"%s\",\n", APP_VERSION);
+#endif
+	printf("  \"frames\": %d,\n", frames);
+	printf("  \"headless\": %s,\n", window ? "false" : "true");
+	printf("  \"flags\": [");
+	for (size_t i = 0; i < flags.size(); i++)
+		printf("%s\"%s\"", i ? ", " : "", flags[i].c_str());
+	printf("],\n");
+	printf("  \"scenarios\": [\n");
+
+	bool failed = false;
+
+	for (size_t s = 0; s < scenarios.size(); s++)
+	{
+		auto& scenario = scenarios[s];
+
+		// each scenario's peak is measured on its own when possible, otherwise it includes the ones before it
+		bool peakWasReset = resetPeakRSS();
+
+		double setupStart = CST_GetPreciseTicks();
+		Screen* screen = scenario.setup();
+		double setupTime = CST_GetPreciseTicks() - setupStart;
+
+		std::vector<double> times;
+		long frameAllocations = 0;
+
+		for (int frame = 0; frame < warmup + frames; frame++)
+		{
+			if (scenario.tick)
+				scenario.tick(screen, frame);
+
+			// redraw every frame, even if nothing moved
+			screen->needsRedraw = true;
+
+			long allocationsBefore = allocations;
+			double start = CST_GetPreciseTicks();
+			display->runFrame();
+			double elapsed = CST_GetPreciseTicks() - start;
+
+			if (frame >= warmup)
+			{
+				times.push_back(elapsed);
+				frameAllocations += allocations - allocationsBefore;
+			}
+		}
+
+		std::string error = scenario.check ? scenario.check(screen) : "";
+		if (!error.empty())
+		{
+			fprintf(stderr, "%s: %s\n", scenario.name.c_str(), error.c_str());
+			failed = true;
+		}
+
+		std::vector<double> sorted = times;
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0;
+		for (double time : times)
+			total += time;
+
+		printf("    {\n");
+		printf("      \"name\": %s,\n", jsonString(scenario.name).c_str());
+		if (!error.empty())
+			printf("      \"error\": %s,\n", jsonString(error).c_str());
+		printf("      \"setup_ms\": %.3f,\n", setupTime);
+		printf("      \"frame_ms\": { \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n",
+			total / times.size(), percentile(sorted, 50), percentile(sorted, 90), percentile(sorted, 95),
+			percentile(sorted, 99), sorted.back());
+		printf("      \"allocations_per_frame\": %.2f,\n", (double)frameAllocations / times.size());
+		if (peakWasReset)
+			printf("      \"peak_rss_kb\": %ld,\n", peakRSSSinceReset());
+		printf("      \"process_peak_rss_kb\": %ld\n", processPeakRSS());
+		printf("    }%s\n", s + 1 < scenarios.size() ? "," : "");
+		fflush(stdout);
+
+		RootDisplay::clearScreens();
+	}
+
+	printf("  ]\n}\n");
+
+	display.reset();
+	Clock::set(NULL);
+	return failed ? 1 : 0;
+}
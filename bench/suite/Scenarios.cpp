@@ -0,0 +1,263 @@
+#include "Scenarios.hpp"
+
+#include "Constraint.hpp"
+#include "DropDown.hpp"
+#include "Grid.hpp"
+#include "ListElement.hpp"
+#include "RootDisplay.hpp"
+#include "Screen.hpp"
+#include "TextElement.hpp"
+#include "Texture.hpp"
+#include "colorspaces.hpp"
+
+#include <string>
+
+using namespace Chesto;
+
+// how often the cursor scenario presses a direction, in frames
+#define BENCH_PRESS_FRAMES 4
+
+// how many different images the image scenario cycles through (so most loads are cache hits)
+#define BENCH_IMAGE_VARIANTS 16
+
+// a screen built from a function, so scenarios don't each need a class
+class BenchScreen : public Screen
+{
+public:
+	BenchScreen(std::function<void(BenchScreen*)> build)
+		: build(build)
+	{
+		rebuildUI();
+	}
+
+	void rebuildUI() override
+	{
+		removeAll();
+		build(this);
+	}
+
+private:
+	std::function<void(BenchScreen*)> build;
+};
+
+// a solid colored image, generated once per variant and then loaded from the texture cache
+class BenchImage : public Texture
+{
+public:
+	BenchImage(int variant, int size)
+	{
+		std::string key = "bench:" + std::to_string(variant);
+		if (!loadFromCache(key))
+		{
+			CST_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_RGBA8888);
+			SDL_FillRect(surface, NULL, SDL_MapRGBA(surface->format, variant * 15, 0x80, 0xff - variant * 15, 0xff));
+			loadFromSurfaceSaveToCache(key, surface);
+			CST_FreeSurface(surface);
+		}
+
+		width = size;
+		height = size;
+	}
+};
+
+// keep a list flinging back and forth between its top and bottom, through its inertia
+static void fling(ListElement* list, int maxScroll, int frame, int& direction)
+{
+	if (list->elasticCounter != 0)
+		return;
+
+	// turn around at either end, once the last fling burns out
+	if (list->y <= -maxScroll)
+		direction = 1;
+	else if (list->y >= 0)
+		direction = -1;
+
+	list->elasticCounter = direction * (60 + frame % 20);
+}
+
+// press (and later release) a key, through SDL's event queue like a real one
+static void pushKey(SDL_Keycode key, bool down)
+{
+	SDL_Event event = {};
+	event.type = down ? SDL_KEYDOWN : SDL_KEYUP;
+	event.key.state = down ? SDL_PRESSED : SDL_RELEASED;
+	event.key.keysym.sym = key;
+	SDL_PushEvent(&event);
+}
+
+static std::unique_ptr<ListElement> makeRows(int count)
+{
+	auto list = std::make_unique<ListElement>();
+	list->width = SCREEN_WIDTH;
+	for (int i = 0; i < count; i++)
+	{
+		auto row = list->createNode<Element>();
+		row->width = SCREEN_WIDTH - 40;
+		row->height = 60;
+		row->position(20, i * 70);
+		row->hasBackground = true;
+		row->backgroundColor = i % 2 ? fromRGB(0x40, 0x40, 0x48) : fromRGB(0x30, 0x30, 0x38);
+
+		auto label = row->createNode<TextElement>("Row " + std::to_string(i), 20);
+		label->constrain(ALIGN_LEFT | ALIGN_CENTER_VERTICAL, 20);
+	}
+	list->height = count * 70;
+	return list;
+}
+
+// a chain of nested boxes, each positioned by constraints against its parent and its sibling
+static void addNested(Element* parent, int depth)
+{
+	if (depth == 0)
+		return;
+
+	auto first = parent->createNode<Element>();
+	first->width = parent->width / 2 - 4;
+	first->height = parent->height - 8;
+	first->hasBackground = true;
+	first->backgroundColor = fromRGB(depth * 20, 0x60, 0x90);
+	first->constrain(ALIGN_LEFT | ALIGN_CENTER_VERTICAL, 2);
+
+	auto second = parent->createNode<Element>();
+	second->width = parent->width / 2 - 4;
+	second->height = parent->height - 8;
+	second->hasBackground = true;
+	second->backgroundColor = fromRGB(0x90, depth * 20, 0x60);
+	second->constrainToTarget(first, ALIGN_TOP | OFFSET_LEFT, 4);
+
+	addNested(first, depth - 1);
+	addNested(second, depth - 1);
+}
+
+std::vector<Scenario> getScenarios()
+{
+	std::vector<Scenario> scenarios;
+
+	scenarios.push_back({ "text_1000",
+		[]() -> Screen* {
+			auto screen = std::make_unique<BenchScreen>([](BenchScreen* self) {
+				for (int i = 0; i < 1000; i++)
+				{
+					auto text = self->createNode<TextElement>("Text " + std::to_string(i), 14);
+					text->position((i % 25) * 51, (i / 25) * 18);
+				}
+			});
+			Screen* raw = screen.get();
+			RootDisplay::pushScreen(std::move(screen));
+			return raw;
+		},
+		NULL,
+		NULL });
+
+	scenarios.push_back({ "grid_images_500",
+		[]() -> Screen* {
+			auto screen = std::make_unique<BenchScreen>([](BenchScreen* self) {
+				auto grid = self->createNode<Grid>(10, SCREEN_WIDTH, 10, 10);
+				for (int i = 0; i < 500; i++)
+					grid->createNode<BenchImage>(i % BENCH_IMAGE_VARIANTS, 112);
+				grid->refresh();
+			});
+			Screen* raw = screen.get();
+			RootDisplay::pushScreen(std::move(screen));
+			return raw;
+		},
+		[](Screen* screen, int frame) {
+			// scroll down through the grid and wrap around
+			Element* grid = screen->elements[0].get();
+			int maxScroll = std::max(grid->height - SCREEN_HEIGHT, 1);
+			grid->y = -((frame * 8) % maxScroll);
+		},
+		NULL });
+
+	scenarios.push_back({ "nested_constraints",
+		[]() -> Screen* {
+			auto screen = std::make_unique<BenchScreen>([](BenchScreen* self) {
+				auto root = self->createNode<Element>();
+				root->width = SCREEN_WIDTH;
+				root->height = SCREEN_HEIGHT;
+				addNested(root, 10);
+			});
+			Screen* raw = screen.get();
+			RootDisplay::pushScreen(std::move(screen));
+			return raw;
+		},
+		[](Screen* screen, int frame) {
+			// nudge the outermost box, so everything constrained inside of it moves
+			Element* root = screen->elements[0].get();
+			root->x = frame % 40;
+		},
+		NULL });
+
+	scenarios.push_back({ "dropdown_300",
+		[]() -> Screen* {
+			std::vector<std::pair<std::string, std::string>> choices;
+			for (int i = 0; i < 300; i++)
+				choices.push_back({ std::to_string(i), "Choice " + std::to_string(i) });
+
+			auto dropdown = std::make_unique<DropDownChoices>(choices, [](std::string) {}, true, "Pick one");
+			Screen* raw = dropdown.get();
+			RootDisplay::pushScreen(std::move(dropdown));
+			return raw;
+		},
+		[direction = -1](Screen* screen, int frame) mutable {
+			auto dropdown = (DropDownChoices*)screen;
+			fling(dropdown->scrollList, std::max(dropdown->container->height - SCREEN_HEIGHT, 0), frame, direction);
+		},
+		NULL });
+
+	scenarios.push_back({ "list_inertia",
+		[]() -> Screen* {
+			auto screen = std::make_unique<BenchScreen>([](BenchScreen* self) {
+				self->addNode(makeRows(400));
+			});
+			Screen* raw = screen.get();
+			RootDisplay::pushScreen(std::move(screen));
+			return raw;
+		},
+		[direction = -1](Screen* screen, int frame) mutable {
+			auto list = (ListElement*)screen->elements[0].get();
+			fling(list, list->height - SCREEN_HEIGHT, frame, direction);
+		},
+		NULL });
+
+	scenarios.push_back({ "grid_cursor",
+		[]() -> Screen* {
+			auto screen = std::make_unique<BenchScreen>([](BenchScreen* self) {
+				auto list = self->createNode<ListElement>();
+				list->width = SCREEN_WIDTH;
+				auto grid = list->createNode<Grid>(8, SCREEN_WIDTH, 10, 10);
+				for (int i = 0; i < 400; i++)
+				{
+					auto cell = grid->createNode<Element>();
+					cell->width = 140;
+					cell->height = 80;
+					cell->hasBackground = true;
+					cell->backgroundColor = fromRGB(0x40, 0x40, 0x48);
+					cell->touchable = true;
+				}
+				grid->refresh();
+				list->height = grid->height;
+			});
+			Screen* raw = screen.get();
+			RootDisplay::pushScreen(std::move(screen));
+			return raw;
+		},
+		[](Screen* screen, int frame) {
+			// walk the cursor right along a row, then down to the next one
+			int press = frame / BENCH_PRESS_FRAMES;
+			SDL_Keycode key = press % 8 == 7 ? SDLK_DOWN : SDLK_RIGHT;
+			if (frame % BENCH_PRESS_FRAMES == 0)
+				pushKey(key, true);
+			else if (frame % BENCH_PRESS_FRAMES == 1)
+				pushKey(key, false);
+		},
+		[](Screen* screen) -> std::string {
+			// key events have to reach the grid's cursor, including when only the focused path gets them
+			auto grid = (Grid*)screen->elements[0]->elements[0].get();
+			if (grid->touchMode || grid->highlighted <= 0)
+				return "the d-pad didn't move the grid's cursor";
+			return "";
+		} });
+
+	return scenarios;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Chesto {
+class Screen;
+}
+
+/// a synthetic screen to be timed by the benchmark runner
+struct Scenario
+{
+	std::string name;
+
+	/// build the scenario's screens and push them, returning the one that's ticked every frame
+	std::function<Chesto::Screen*()> setup;
+
+	/// change something before the given frame, like a user would (the screen is redrawn either way)
+	std::function<void(Chesto::Screen* screen, int frame)> tick;
+
+	/// after the last frame, make sure the screen ended up as expected, returning what's wrong (or "" if nothing)
+	std::function<std::string(Chesto::Screen* screen)> check;
+};
+
+/// every scenario, in the order they're run by default
+std::vector<Scenario> getScenarios();
@@ -1,30 +1,249 @@
 #include "Animation.hpp"
-#include "./DrawUtils.hpp"
+#include "Clock.hpp"
+#include "Element.hpp"
+#include "Scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 namespace Chesto {
 
-Animation::Animation(int startTime, int duration, std::function<void(float)> onStep, std::function<void()> onFinish) {
-    this->startTime = startTime;
-    this->duration = duration;
-    this->onStep = onStep;
-    this->onFinish = onFinish;
+std::vector<Tween> AnimationTimeline::tweens;
+std::unordered_map<int, AnimationTimeline::Callbacks> AnimationTimeline::callbacks;
+int AnimationTimeline::nextId = 1;
+
+int AnimationTimeline::tween(Element* element, int property, float to, int duration, int easing,
+	std::function<void()> onFinish, int delay)
+{
+	// a property can only be going to one place at a time
+	if (element && element->activeTweens > 0)
+	{
+		for (size_t i = 0; i < tweens.size(); i++)
+		{
+			if (!tweens[i].done && tweens[i].element == element && tweens[i].property == property)
+				retire(i);
+		}
+	}
+
+	// the starting value is read when the tween starts, in case something else moves it in the meantime
+	return add({ element, 0, property, easing, Clock::now() + delay, duration, 0, to, false, false }, NULL, onFinish);
+}
+
+int AnimationTimeline::animate(Element* element, int duration, std::function<void(float)> onStep,
+	std::function<void()> onFinish, int easing, int delay)
+{
+	return add({ element, 0, TWEEN_CALLBACK, easing, Clock::now() + delay, duration, 0, 1, false, false }, onStep, onFinish);
+}
+
+int AnimationTimeline::add(Tween tween, std::function<void(float)> onStep, std::function<void()> onFinish)
+{
+	tween.id = nextId++;
+	if (onStep || onFinish)
+		callbacks[tween.id] = { onStep, onFinish };
+
+	if (tween.element)
+	{
+		tween.element->activeTweens++;
+
+		// animating subtrees can't be culled, or they'd stop being redrawn
+		tween.element->invalidateSubtreeExtent();
+	}
+
+	tweens.push_back(tween);
+
+	// make sure the loop is awake for the first step
+	Scheduler::requestFrameIn(0);
+	return tween.id;
+}
+
+void AnimationTimeline::cancel(int id)
+{
+	for (size_t i = 0; i < tweens.size(); i++)
+	{
+		if (tweens[i].id == id && !tweens[i].done)
+			retire(i);
+	}
+}
+
+void AnimationTimeline::cancelAll(Element* element)
+{
+	if (!element || element->activeTweens == 0)
+		return;
+
+	for (size_t i = 0; i < tweens.size(); i++)
+	{
+		if (tweens[i].element == element && !tweens[i].done)
+			retire(i);
+	}
+}
+
+void AnimationTimeline::retire(size_t index)
+{
+	// the entry (and its callbacks, which may be running) stay around until the end of the next step
+	Tween& tween = tweens[index];
+	tween.done = true;
+	if (tween.element)
+		tween.element->activeTweens--;
 }
 
-bool Animation::isFinished() {
-    return CST_GetTicks() > startTime + duration;
+float AnimationTimeline::ease(int easing, float p)
+{
+	switch (easing)
+	{
+	case EASE_IN_QUAD:
+		return p * p;
+	case EASE_OUT_QUAD:
+		return p * (2 - p);
+	case EASE_IN_OUT_QUAD:
+		return p < 0.5f ? 2 * p * p : -1 + (4 - 2 * p) * p;
+	case EASE_IN_CUBIC:
+		return p * p * p;
+	case EASE_OUT_CUBIC:
+	{
+		float f = p - 1;
+		return f * f * f + 1;
+	}
+	case EASE_IN_OUT_CUBIC:
+	{
+		if (p < 0.5f)
+			return 4 * p * p * p;
+		float f = 2 * p - 2;
+		return 0.5f * f * f * f + 1;
+	}
+	case EASE_OUT_BACK:
+	{
+		// overshoots a little before settling
+		const float c1 = 1.70158f, c3 = c1 + 1;
+		float f = p - 1;
+		return 1 + c3 * f * f * f + c1 * f * f;
+	}
+	default:
+		return p;
+	}
 }
 
-bool Animation::step() {
-    if (isFinished()) {
-        onFinish();
-        return true;
-    }
+float AnimationTimeline::getProperty(Element* element, int property)
+{
+	switch (property)
+	{
+	case TWEEN_X:
+		return element->x;
+	case TWEEN_Y:
+		return element->y;
+	case TWEEN_SCALE:
+		return element->scale;
+	case TWEEN_OPACITY:
+		return element->opacity;
+	case TWEEN_ANGLE:
+		return element->angle;
+	default:
+		return 0;
+	}
+}
+
+void AnimationTimeline::setProperty(Element* element, int property, float value)
+{
+	switch (property)
+	{
+	case TWEEN_X:
+		element->x = (int)std::lround(value);
+		break;
+	case TWEEN_Y:
+		element->y = (int)std::lround(value);
+		break;
+	case TWEEN_SCALE:
+		element->scale = value;
+		break;
+	case TWEEN_OPACITY:
+		element->opacity = std::min(std::max((int)std::lround(value), 0), 0xff);
+		break;
+	case TWEEN_ANGLE:
+		element->angle = value;
+		break;
+	}
+}
+
+bool AnimationTimeline::step(int now)
+{
+	bool running = false;
+	int nextStart = -1;
+
+	// tweens added by callbacks during this step wait until the next one
+	size_t count = tweens.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		Tween& tween = tweens[i];
+		if (tween.done)
+			continue;
+
+		if (now < tween.startTime)
+		{
+			// still delayed, so only a frame at its start time is needed
+			if (nextStart < 0 || tween.startTime < nextStart)
+				nextStart = tween.startTime;
+			continue;
+		}
+
+		running = true;
+		Element* element = tween.element;
+		int id = tween.id;
+
+		if (!tween.started)
+		{
+			tween.started = true;
+			if (element && tween.property != TWEEN_CALLBACK)
+				tween.from = getProperty(element, tween.property);
+		}
+
+		float progress = tween.duration > 0 ? (float)(now - tween.startTime) / (float)tween.duration : 1;
+		progress = std::min(std::max(progress, 0.0f), 1.0f);
+		float eased = ease(tween.easing, progress);
+
+		if (element)
+		{
+			if (tween.property != TWEEN_CALLBACK)
+				setProperty(element, tween.property, tween.from + (tween.to - tween.from) * eased);
+
+			// the element may be on a screen that isn't processed, or drawn from a display list or layer
+			element->requestRedraw();
+			element->tweened = true;
+		}
+
+		// callbacks can add, cancel, or free anything (including this tween's element), so tween isn't used after them
+		auto found = callbacks.find(id);
+		Callbacks* funcs = found != callbacks.end() ? &found->second : NULL;
+		if (funcs && funcs->onStep)
+			funcs->onStep(eased);
+
+		if (progress >= 1)
+		{
+			if (!tweens[i].done)
+				retire(i);
+			if (funcs && funcs->onFinish)
+				funcs->onFinish();
+		}
+	}
+
+	// drop finished tweens, keeping the rest in order
+	size_t kept = 0;
+	for (size_t i = 0; i < tweens.size(); i++)
+	{
+		if (tweens[i].done)
+			callbacks.erase(tweens[i].id);
+		else
+			tweens[kept++] = tweens[i];
+	}
+	tweens.resize(kept);
+
+	if (nextStart >= 0)
+		Scheduler::requestFrameIn(nextStart - now);
+
+	return running;
+}
 
-    if (onStep != NULL) {
-        float progress = (float)(CST_GetTicks() - startTime) / (float)duration;
-        onStep(progress);
-    }
-    return false;
+size_t AnimationTimeline::activeCount()
+{
+	return std::count_if(tweens.begin(), tweens.end(), [](const Tween& tween) { return !tween.done; });
 }
 
-} // namespace Chesto
\ No newline at end of file
+} // namespace Chesto
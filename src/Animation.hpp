@@ -1,19 +1,91 @@
 #pragma once
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 namespace Chesto {
 
-class Animation
+class Element;
+
+// easing curves, for how progress moves from 0.0 to 1.0 over a tween
+#define EASE_LINEAR 0
+#define EASE_IN_QUAD 1
+#define EASE_OUT_QUAD 2
+#define EASE_IN_OUT_QUAD 3
+#define EASE_IN_CUBIC 4
+#define EASE_OUT_CUBIC 5
+#define EASE_IN_OUT_CUBIC 6
+#define EASE_OUT_BACK 7
+
+// element properties that can be tweened
+#define TWEEN_X 0
+#define TWEEN_Y 1
+#define TWEEN_SCALE 2
+#define TWEEN_OPACITY 3
+#define TWEEN_ANGLE 4
+#define TWEEN_CALLBACK 5 // no property, just onStep
+
+struct Tween
+{
+	Element* element;
+	int id;
+	int property;
+	int easing;
+	int startTime;
+	int duration;
+	float from, to;
+	bool started;
+	bool done; // finished or cancelled, and waiting to be removed
+};
+
+/**
+ * The AnimationTimeline steps every running animation once per frame, from one packed array.
+ * Tweens either move a property of an element (x, y, scale, opacity or angle) to a target value along an easing
+ * curve, or call an onStep function with the eased progress. When nothing is running, the main loop can sleep,
+ * and delayed tweens ask the Scheduler for a frame at exactly the time they start.
+ */
+class AnimationTimeline
 {
 public:
-	Animation(int startTime, int duration, std::function<void(float)> onStep, std::function<void()> onFinish);
-
-    bool isFinished();
-    bool step();
-    int startTime = 0;
-    int duration = 0;
-    std::function<void(float)> onStep = NULL;
-    std::function<void()> onFinish = NULL;
+	/// move a property of the element from its value when the tween starts to the given one, over duration ms
+	/// (replacing any tween of the same property on that element), returns an id for cancel
+	static int tween(Element* element, int property, float to, int duration, int easing = EASE_OUT_QUAD,
+		std::function<void()> onFinish = NULL, int delay = 0);
+
+	/// call onStep every frame with the eased progress from 0.0 to 1.0 over duration ms, then onFinish
+	static int animate(Element* element, int duration, std::function<void(float)> onStep,
+		std::function<void()> onFinish = NULL, int easing = EASE_LINEAR, int delay = 0);
+
+	/// stop a tween where it is, without calling onFinish
+	static void cancel(int id);
+
+	/// stop every tween on the given element
+	static void cancelAll(Element* element);
+
+	/// apply an easing curve to a linear progress from 0.0 to 1.0
+	static float ease(int easing, float progress);
+
+	/// advance every tween to the given time, returns true if any are still running
+	static bool step(int now);
+
+	/// how many tweens are waiting or running
+	static size_t activeCount();
+
+private:
+	static int add(Tween tween, std::function<void(float)> onStep, std::function<void()> onFinish);
+	static float getProperty(Element* element, int property);
+	static void setProperty(Element* element, int property, float value);
+	static void retire(size_t index);
+
+	struct Callbacks
+	{
+		std::function<void(float)> onStep;
+		std::function<void()> onFinish;
+	};
+
+	static std::vector<Tween> tweens;
+	static std::unordered_map<int, Callbacks> callbacks;
+	static int nextId;
 };
 
 } // namespace Chesto
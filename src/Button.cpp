@@ -1,4 +1,5 @@
 #include "Button.hpp"
+#include "FocusManager.hpp"
 #include <iostream>
 
 namespace Chesto {
@@ -33,6 +34,10 @@ Button::Button(std::string message, int button, bool dark, int size, int width)
 
 	this->touchable = true;
 	this->hasBackground = true;
+
+	// physical button shortcuts work regardless of what's focused
+	if (physical != 0)
+		FocusManager::addListener(this);
 }
 
 void Button::updateBounds()
@@ -0,0 +1,58 @@
+#include "Clock.hpp"
+#include "DrawUtils.hpp"
+
+namespace Chesto {
+
+static RealClock realClock;
+Clock* Clock::current = &realClock;
+
+int Clock::now()
+{
+	return current->ticks();
+}
+
+Clock* Clock::get()
+{
+	return current;
+}
+
+void Clock::set(Clock* clock)
+{
+	current = clock ? clock : &realClock;
+}
+
+int RealClock::ticks()
+{
+	return CST_GetTicks();
+}
+
+VirtualClock::VirtualClock(double frameLength, double start)
+{
+	this->frameLength = frameLength;
+	this->time = start;
+}
+
+int VirtualClock::ticks()
+{
+	return (int)time;
+}
+
+void VirtualClock::beginFrame()
+{
+	time += frameLength;
+}
+
+bool VirtualClock::skip(int ms)
+{
+	// nothing happens in between frames, so the wait can be jumped over
+	advance(ms);
+	return true;
+}
+
+void VirtualClock::advance(double ms)
+{
+	if (ms > 0)
+		time += ms;
+}
+
+} // namespace Chesto
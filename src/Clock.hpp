@@ -0,0 +1,62 @@
+#pragma once
+
+namespace Chesto {
+
+/**
+ * Everything that depends on the time (animations, timers, the highlight pulse, and main loop pacing)
+ * reads it from the current Clock. Normally that's the real one, but a VirtualClock can be swapped in
+ * so that a run is exactly the same every time, like for benchmarks or visual tests.
+ */
+class Clock
+{
+public:
+	virtual ~Clock() = default;
+
+	/// the current time, in ms
+	virtual int ticks() = 0;
+
+	/// called at the start of every frame
+	virtual void beginFrame() {}
+
+	/// let ms of idle time pass without blocking, returns false if it has to be waited out for real
+	virtual bool skip(int ms) { return false; }
+
+	/// the current time on the current clock, in ms
+	static int now();
+
+	/// the clock that's currently in use
+	static Clock* get();
+
+	/// use the given clock from now on (NULL goes back to the real one), it's not owned
+	static void set(Clock* clock);
+
+private:
+	static Clock* current;
+};
+
+/// the wall clock time (from SDL)
+class RealClock : public Clock
+{
+public:
+	int ticks() override;
+};
+
+/// a clock that only moves when it's told to, by a fixed amount every frame and/or manually
+class VirtualClock : public Clock
+{
+public:
+	/// start at the given time, advancing by frameLength ms every frame (0 to only advance manually)
+	VirtualClock(double frameLength = 1000.0 / 60, double start = 0);
+
+	int ticks() override;
+	void beginFrame() override;
+	bool skip(int ms) override;
+
+	/// move the time forward by the given number of ms
+	void advance(double ms);
+
+	double time = 0;
+	double frameLength = 0;
+};
+
+} // namespace Chesto
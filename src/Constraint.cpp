@@ -1,5 +1,6 @@
 #include "Constraint.hpp"
 #include "RootDisplay.hpp"
+#include "ConstraintGraph.hpp"
 
 namespace Chesto {
 
@@ -21,18 +22,24 @@ Constraint::Constraint(int flags, int padding, std::vector<Element*> targets) {
 }
 
 void Constraint::clearFlags() {
+    RootDisplay::layoutGeneration++;
     positioningFlags = 0;
 }
 
 void Constraint::addFlags(int flags) {
+    RootDisplay::layoutGeneration++;
     positioningFlags |= flags;
 }
 
 void Constraint::clearTargets() {
+    RootDisplay::layoutGeneration++;
+    ConstraintGraph::structureSerial++;
     targets.clear();
 }
 
 void Constraint::addTarget(Element* target) {
+    RootDisplay::layoutGeneration++;
+    ConstraintGraph::structureSerial++;
     targets.push_back(target);
 }
 
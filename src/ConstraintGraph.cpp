@@ -0,0 +1,165 @@
+#include "ConstraintGraph.hpp"
+#include "Constraint.hpp"
+#include "Element.hpp"
+
+#include <algorithm>
+
+namespace Chesto {
+
+int ConstraintGraph::structureSerial = 0;
+
+void ConstraintGraph::update(const std::vector<std::pair<Element*, Element*>>& roots)
+{
+	if (builtSerial == structureSerial && roots == this->roots)
+		return;
+
+	this->roots = roots;
+	build();
+	builtSerial = structureSerial;
+}
+
+void ConstraintGraph::build()
+{
+	nodes.clear();
+	indices.clear();
+	order.clear();
+	cyclic.clear();
+
+	// nodes are added in tree order, which is also the fallback order for cycles
+	for (auto& root : roots)
+		addSubtree(root.first, root.second);
+
+	// an element depends on the parent it's laid out in, and on its constraint targets
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		Element* element = nodes[i].element;
+		addEdge(nodes[i].layoutParent, i);
+
+		for (auto& constraint : element->constraints)
+		{
+			for (Element* target : constraint->targets)
+				addEdge(target, i);
+		}
+	}
+
+	// Kahn's algorithm: repeatedly take an element whose dependencies have all been placed
+	std::vector<int> remaining(nodes.size());
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		remaining[i] = nodes[i].dependencies;
+		if (remaining[i] == 0)
+			order.push_back(i);
+	}
+
+	for (size_t next = 0; next < order.size(); next++)
+	{
+		for (int dependent : nodes[order[next]].dependents)
+		{
+			if (--remaining[dependent] == 0)
+				order.push_back(dependent);
+		}
+	}
+
+	// anything left over is stuck behind a cycle
+	if (order.size() < nodes.size())
+	{
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			if (remaining[i] > 0)
+			{
+				order.push_back(i);
+				cyclic.push_back(nodes[i].element);
+			}
+		}
+
+#ifdef DEBUG
+		printf("[Chesto] Warning: %zu elements are in or depend on a constraint cycle\n", cyclic.size());
+#endif
+	}
+
+	for (size_t i = 0; i < order.size(); i++)
+		nodes[order[i]].position = i;
+}
+
+void ConstraintGraph::addSubtree(Element* element, Element* layoutParent)
+{
+	if (!element || indices.count(element))
+		return;
+
+	auto parent = indices.find(layoutParent);
+	int parentIndex = parent != indices.end() ? parent->second : -1;
+
+	indices[element] = nodes.size();
+	nodes.push_back({ element, layoutParent, parentIndex, {}, 0, 0 });
+
+	for (auto& child : element->elements)
+		addSubtree(child.get(), element);
+}
+
+void ConstraintGraph::addEdge(Element* from, int to)
+{
+	// dependencies outside of the graph (like hidden elements or the root) are already positioned
+	auto it = indices.find(from);
+	if (it == indices.end() || it->second == to)
+		return;
+
+	nodes[it->second].dependents.push_back(to);
+	nodes[to].dependencies++;
+}
+
+void ConstraintGraph::evaluate()
+{
+	// hidden subtrees are left where they are until they're shown again
+	// (a layout parent always comes before its children, so it's already been checked)
+	std::vector<char> skipped(nodes.size(), false);
+	for (int index : order)
+	{
+		int parentIndex = nodes[index].parentIndex;
+		skipped[index] = nodes[index].element->hidden || (parentIndex >= 0 && skipped[parentIndex]);
+		if (!skipped[index])
+			nodes[index].element->recalcPosition(nodes[index].layoutParent);
+	}
+}
+
+void ConstraintGraph::evaluateFrom(Element* changed)
+{
+	auto it = indices.find(changed);
+	if (it == indices.end())
+		return;
+
+	// find everything downstream of the changed element
+	std::vector<int> affected = { it->second };
+	std::vector<bool> seen(nodes.size(), false);
+	seen[it->second] = true;
+	for (size_t next = 0; next < affected.size(); next++)
+	{
+		for (int dependent : nodes[affected[next]].dependents)
+		{
+			if (!seen[dependent])
+			{
+				seen[dependent] = true;
+				affected.push_back(dependent);
+			}
+		}
+	}
+
+	// and recalculate them in dependency order
+	std::sort(affected.begin(), affected.end(), [this](int a, int b) {
+		return nodes[a].position < nodes[b].position;
+	});
+
+	for (int index : affected)
+	{
+		// only the affected nodes are visited, so look up whether anything above them is hidden
+		bool hidden = false;
+		for (int cur = index; cur >= 0 && !hidden; cur = nodes[cur].parentIndex)
+			hidden = nodes[cur].element->hidden;
+		if (hidden)
+			continue;
+
+		nodes[index].element->invalidateLayout();
+		nodes[index].element->recalcPosition(nodes[index].layoutParent);
+	}
+}
+
+} // namespace Chesto
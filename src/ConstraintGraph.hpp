@@ -0,0 +1,62 @@
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Chesto {
+
+class Element;
+
+/**
+ * The ConstraintGraph orders the layout of an Element tree by what each element depends on: its parent,
+ * and the targets of its constraints. Evaluating in this (topological) order means an element is always
+ * positioned after everything it's positioned from, no matter where they are in the tree.
+ * It's used by the layout pass when RootDisplay::cacheLayout is set.
+ */
+class ConstraintGraph
+{
+public:
+	/// rebuild the graph if the given roots (each with the parent it's laid out in) or any tree structure changed
+	void update(const std::vector<std::pair<Element*, Element*>>& roots);
+
+	/// recalculate every element's position in dependency order
+	void evaluate();
+
+	/// recalculate only the given element and everything that depends on it, directly or not
+	void evaluateFrom(Element* changed);
+
+	/// elements that couldn't be ordered because they're in (or depend on) a constraint cycle
+	/// these are evaluated last, in tree order
+	std::vector<Element*> cyclic;
+
+	/// increases whenever elements are added, removed, or constrained to different targets
+	/// (hidden elements stay in the graph, so hiding and showing them doesn't need a rebuild)
+	static int structureSerial;
+
+private:
+	struct Node
+	{
+		Element* element;
+		Element* layoutParent;
+		int parentIndex; // the layout parent's node, or -1 if it's outside of the graph
+		std::vector<int> dependents;
+		int dependencies;
+		int position;
+	};
+
+	void build();
+	void addSubtree(Element* element, Element* layoutParent);
+	void addEdge(Element* from, int to);
+
+	std::vector<std::pair<Element*, Element*>> roots;
+	int builtSerial = -1;
+
+	std::vector<Node> nodes;
+	std::unordered_map<Element*, int> indices;
+
+	// node indices in evaluation order, followed by any cyclic ones
+	std::vector<int> order;
+};
+
+} // namespace Chesto
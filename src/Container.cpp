@@ -3,6 +3,9 @@
 
 namespace Chesto {
 
+// returned by syncItems when no child needs to be laid out again
+static const size_t NO_CHANGE = (size_t)-1;
+
 Container::Container(int layout, int padding)
 {
 	// these values only affect adds into this container
@@ -11,18 +14,349 @@ Container::Container(int layout, int padding)
 }
 
 Element* Container::add(std::unique_ptr<Element> elem)
+{
+	Element* rawPtr = elem.get();
+
+	if (flex)
+	{
+		// only the new child needs placing, if everything before it is already laid out
+		bool inSync = syncItems() == NO_CHANGE;
+		addNode(std::move(elem));
+
+		if (inSync)
+		{
+			int main = mainOf(rawPtr), cross = crossOf(rawPtr);
+			items.push_back({ rawPtr, main, cross, main, cross, rawPtr->hidden, 0, 0, 0 });
+			flow(items.size() - 1);
+		}
+		else
+			reflow();
+
+		return rawPtr;
+	}
+
+	place(rawPtr);
+	addNode(std::move(elem)); // transfers ownership
+
+	return rawPtr;
+}
+
+void Container::place(Element* child)
 {
 	int newPosX = (layout == ROW_LAYOUT) ? this->width + padding : this->x;
 	int newPosY = (layout == COL_LAYOUT) ? this->height + padding : this->y;
 
-	Element* rawPtr = elem.get();
-	rawPtr->setPosition(newPosX, newPosY);
-	addNode(std::move(elem)); // transfers ownership
+	child->setPosition(newPosX, newPosY);
 
-	this->width = (layout == ROW_LAYOUT) ? this->width + rawPtr->width + padding : std::max(this->width, rawPtr->width);
-	this->height = (layout == COL_LAYOUT) ? this->height + rawPtr->height + padding :  std::max(this->height, rawPtr->height);
+	this->width = (layout == ROW_LAYOUT) ? this->width + child->width + padding : std::max(this->width, child->width);
+	this->height = (layout == COL_LAYOUT) ? this->height + child->height + padding :  std::max(this->height, child->height);
+}
 
-	return rawPtr;
+void Container::layoutAdded(size_t first)
+{
+	if (flex)
+	{
+		reflow();
+		return;
+	}
+
+	for (size_t i = first; i < elements.size(); i++)
+		place(elements[i].get());
+}
+
+Container* Container::setFlex(int align, bool wrap, int mainSize)
+{
+	this->flex = true;
+	this->flexAlign = align;
+	this->flexWrap = wrap;
+	this->mainSize = mainSize;
+
+	// every child's current size is its natural size
+	items.clear();
+	lines.clear();
+	reflow();
+
+	return this;
+}
+
+void Container::setGrow(Element* child, float grow, float shrink)
+{
+	growFactors[child] = { grow, shrink };
+
+	// the free space has to be shared out again
+	if (flex)
+	{
+		syncItems();
+		flow(0);
+	}
+}
+
+void Container::reflow()
+{
+	if (!flex)
+		return;
+
+	size_t changed = syncItems();
+	if (changed != NO_CHANGE)
+		flow(changed);
+}
+
+void Container::remove(Element* child)
+{
+	auto position = std::find_if(elements.begin(), elements.end(),
+		[child](const ElementPtr& e) {
+			return e.get() == child;
+		});
+	if (position == elements.end())
+		return;
+
+	size_t index = position - elements.begin();
+	bool inSync = flex && index < items.size() && items[index].element == child;
+
+	growFactors.erase(child);
+	Element::remove(child);
+
+	if (!flex)
+		return;
+
+	// everything after the removed child moves back to close the gap
+	if (inSync)
+	{
+		items.erase(items.begin() + index);
+		flow(index);
+	}
+	else
+		reflow();
+}
+
+void Container::render(Element* parent)
+{
+	if (hidden) return;
+
+	// pick up any children that resized or were hidden since the last frame
+	reflow();
+
+	Element::render(parent);
+}
+
+size_t Container::syncItems()
+{
+	size_t changed = NO_CHANGE;
+	size_t count = elements.size();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		Element* e = elements[i].get();
+
+		// children were added or removed without going through us, so everything from here is new
+		if (i >= items.size() || items[i].element != e)
+		{
+			items.resize(i);
+			for (size_t j = i; j < count; j++)
+			{
+				Element* next = elements[j].get();
+				int main = mainOf(next), cross = crossOf(next);
+				items.push_back({ next, main, cross, main, cross, next->hidden, 0, 0, 0 });
+			}
+			return std::min(changed, i);
+		}
+
+		FlexItem& item = items[i];
+		int main = mainOf(e), cross = crossOf(e);
+		if (e->hidden != item.hidden || main != item.assignedMain || cross != item.assignedCross)
+		{
+			// a size we didn't assign was set by the child itself, so it's the new natural size
+			if (main != item.assignedMain)
+				item.baseMain = item.assignedMain = main;
+			if (cross != item.assignedCross)
+				item.baseCross = item.assignedCross = cross;
+			item.hidden = e->hidden;
+
+			if (changed == NO_CHANGE)
+				changed = i;
+		}
+	}
+
+	if (items.size() > count)
+	{
+		items.resize(count);
+		changed = std::min(changed, count);
+	}
+
+	return changed;
+}
+
+void Container::flow(size_t from)
+{
+	int gap = padding;
+	size_t line = 0;
+
+	if (from > 0 && from <= items.size() && !lines.empty())
+	{
+		line = std::min((size_t)items[from - 1].line, lines.size() - 1);
+
+		// a line that shared out its free space has to be redone from its start
+		if (lines[line].flexible)
+			from = lines[line].start;
+	}
+	else
+		from = 0;
+
+	// pick up where the child before left off
+	int mainPos = 0, lineCross = 0;
+	if (from == 0)
+	{
+		lines.clear();
+		lines.push_back({ 0, 0, 0, 0, false });
+	}
+	else
+	{
+		lines.resize(line + 1);
+		if (from > lines[line].start)
+		{
+			mainPos = items[from - 1].nextMain;
+			lineCross = items[from - 1].crossSoFar;
+		}
+	}
+
+	for (size_t i = from; i < items.size(); i++)
+	{
+		FlexItem& item = items[i];
+		if (!item.hidden)
+		{
+			// start a new line if this one is full
+			if (flexWrap && mainSize > 0 && i > lines[line].start && mainPos > 0 && mainPos + item.baseMain > mainSize)
+			{
+				finishLine(line, i, from, mainPos - gap, lineCross);
+				int crossPos = lines[line].crossPos + lines[line].crossSize + gap;
+				lines.push_back({ i, crossPos, 0, 0, false });
+				line++;
+				mainPos = 0;
+				lineCross = 0;
+			}
+
+			setMain(item.element, mainPos, item.baseMain);
+			item.assignedMain = item.baseMain;
+			mainPos += item.baseMain + gap;
+			lineCross = std::max(lineCross, item.baseCross);
+		}
+
+		item.line = line;
+		item.nextMain = mainPos;
+		item.crossSoFar = lineCross;
+	}
+
+	finishLine(line, items.size(), from, mainPos > 0 ? mainPos - gap : 0, lineCross);
+
+	// our own size covers every line
+	int mainTotal = mainSize;
+	if (mainTotal <= 0)
+	{
+		mainTotal = 0;
+		for (auto& l : lines)
+			mainTotal = std::max(mainTotal, l.mainLength);
+	}
+	int crossTotal = lines.back().crossPos + lines.back().crossSize;
+
+	this->width = (layout == ROW_LAYOUT) ? mainTotal : crossTotal;
+	this->height = (layout == ROW_LAYOUT) ? crossTotal : mainTotal;
+
+	invalidateDisplayList();
+}
+
+void Container::finishLine(size_t line, size_t end, size_t changedFrom, int mainUsed, int lineCross)
+{
+	FlexLine& l = lines[line];
+	int gap = padding;
+	int oldCross = l.crossSize;
+	bool wasFlexible = l.flexible;
+
+	l.mainLength = mainUsed;
+	l.crossSize = lineCross;
+	l.flexible = false;
+
+	// share out the free space (or the lack of it) between children that can grow or shrink
+	int free = mainSize - mainUsed;
+	if (mainSize > 0 && free != 0 && !growFactors.empty())
+	{
+		float total = 0;
+		for (size_t i = l.start; i < end; i++)
+		{
+			auto it = growFactors.find(items[i].element);
+			if (!items[i].hidden && it != growFactors.end())
+				total += free > 0 ? it->second.first : it->second.second * items[i].baseMain;
+		}
+
+		if (total > 0)
+		{
+			l.flexible = true;
+			int mainPos = 0;
+			for (size_t i = l.start; i < end; i++)
+			{
+				FlexItem& item = items[i];
+				if (item.hidden)
+					continue;
+
+				float factor = 0;
+				auto it = growFactors.find(item.element);
+				if (it != growFactors.end())
+					factor = free > 0 ? it->second.first : it->second.second * item.baseMain;
+
+				int size = std::max(0, item.baseMain + (int)(free * factor / total));
+				setMain(item.element, mainPos, size);
+				item.assignedMain = size;
+				mainPos += size + gap;
+			}
+			l.mainLength = mainPos > 0 ? mainPos - gap : 0;
+		}
+	}
+
+	// align across the line, earlier children only need to move if the line's cross size changed
+	size_t alignFrom = (l.crossSize != oldCross || l.flexible || wasFlexible) ? l.start : std::max(l.start, changedFrom);
+	for (size_t i = alignFrom; i < end; i++)
+	{
+		FlexItem& item = items[i];
+		if (item.hidden)
+			continue;
+
+		int size = (flexAlign == FLEX_ALIGN_STRETCH) ? l.crossSize : item.baseCross;
+		int offset = 0;
+		if (flexAlign == FLEX_ALIGN_CENTER)
+			offset = (l.crossSize - size) / 2;
+		else if (flexAlign == FLEX_ALIGN_END)
+			offset = l.crossSize - size;
+
+		setCross(item.element, l.crossPos + offset, size);
+		item.assignedCross = size;
+	}
+}
+
+void Container::setMain(Element* e, int pos, int size)
+{
+	if (layout == ROW_LAYOUT)
+	{
+		e->x = pos;
+		e->width = size;
+	}
+	else
+	{
+		e->y = pos;
+		e->height = size;
+	}
+}
+
+void Container::setCross(Element* e, int pos, int size)
+{
+	if (layout == ROW_LAYOUT)
+	{
+		e->y = pos;
+		e->height = size;
+	}
+	else
+	{
+		e->x = pos;
+		e->width = size;
+	}
 }
 
-} // namespace Chesto
\ No newline at end of file
+} // namespace Chesto
@@ -2,9 +2,17 @@
 #define CONTAINER_H
 #include "Element.hpp"
 
+#include <unordered_map>
+
 #define ROW_LAYOUT 1
 #define COL_LAYOUT 2
 
+// where children go across the layout direction, in flex mode
+#define FLEX_ALIGN_START 0
+#define FLEX_ALIGN_CENTER 1
+#define FLEX_ALIGN_END 2
+#define FLEX_ALIGN_STRETCH 3
+
 namespace Chesto {
 
 class Container : public Element {
@@ -14,16 +22,86 @@ public:
 
   // override createNode to use Container's add logic instead
   template <typename T, typename... Args> T *createNode(Args &&...args) {
-    auto ptr = std::make_unique<T>(std::forward<Args>(args)...);
-    T *rawPtr = ptr.get();
-    add(std::move(ptr));
+    T *rawPtr = newNode<T>(std::forward<Args>(args)...);
+    add(std::unique_ptr<Element>(rawPtr));
     return rawPtr;
   }
 
+  /// add several children at once, and lay them out in one pass at the end
+  template <typename Range> void addAll(Range &&elems) {
+    size_t first = elements.size();
+    addNodes(elems);
+    layoutAdded(first);
+  }
+
+  /// lay children out flexbox-style along the layout direction, with padding as the gap between them.
+  /// if mainSize is set, children wrap onto new lines (if wrap is on) or grow/shrink to fill it
+  Container *setFlex(int align = FLEX_ALIGN_START, bool wrap = false, int mainSize = 0);
+
+  /// how much a child takes of the free space (grow) or gives up when there isn't enough (shrink), in flex mode
+  void setGrow(Element *child, float grow, float shrink = 0);
+
+  /// reposition children that changed size or visibility since the last layout, and everything after them
+  void reflow();
+
+  /// remove a child, and close the gap it left in flex mode
+  void remove(Element *child) override;
+
+  void render(Element *parent) override;
+
   int layout = 0;
   int padding = 10;
+
+  // flex mode options (see setFlex)
+  bool flex = false;
+  int flexAlign = FLEX_ALIGN_START;
+  bool flexWrap = false;
+  int mainSize = 0;
+
+private:
+  /// position a child the non-flex way, after the ones before it
+  void place(Element *child);
+
+  /// lay out the children from the given index on, after they were added
+  void layoutAdded(size_t first);
+
+  // a child's size as we last saw or assigned it, and where the layout stood after it
+  struct FlexItem {
+    Element *element;
+    int baseMain, baseCross;         // size before growing, shrinking or stretching
+    int assignedMain, assignedCross; // size after
+    bool hidden;
+    int line;
+    int nextMain;   // where the next child in the line starts
+    int crossSoFar; // the largest cross size in the line up to and including this child
+  };
+
+  struct FlexLine {
+    size_t start;
+    int crossPos, crossSize;
+    int mainLength;
+    bool flexible; // free space was shared out, so any change means the whole line is redone
+  };
+
+  /// match items to children and pick up size changes, returning the first index that needs laying out
+  size_t syncItems();
+
+  /// lay out children starting at the given index
+  void flow(size_t from);
+
+  /// finish a line: share out free space, align across, and return its cross size
+  void finishLine(size_t line, size_t end, size_t changedFrom, int mainUsed, int lineCross);
+
+  int mainOf(Element *e) { return layout == ROW_LAYOUT ? e->width : e->height; }
+  int crossOf(Element *e) { return layout == ROW_LAYOUT ? e->height : e->width; }
+  void setMain(Element *e, int pos, int size);
+  void setCross(Element *e, int pos, int size);
+
+  std::vector<FlexItem> items;
+  std::vector<FlexLine> lines;
+  std::unordered_map<Element *, std::pair<float, float>> growFactors;
 };
 
 } // namespace Chesto
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,192 @@
+#include "DisplayList.hpp"
+
+#include <algorithm>
+
+namespace Chesto {
+
+DisplayList* DisplayList::recording = NULL;
+CST_Color DisplayList::recordColor = { 0, 0, 0, 0xff };
+bool DisplayList::recordBlend = false;
+int DisplayList::generation = 0;
+
+void DisplayList::clear()
+{
+	commands.clear();
+	strings.clear();
+}
+
+void DisplayList::append(const DisplayList& other)
+{
+	// text commands refer to strings by index, so they need to be shifted over
+	int stringOffset = (int)strings.size();
+	size_t start = commands.size();
+
+	commands.insert(commands.end(), other.commands.begin(), other.commands.end());
+	strings.insert(strings.end(), other.strings.begin(), other.strings.end());
+
+	if (stringOffset > 0 && !other.strings.empty())
+	{
+		for (size_t i = start; i < commands.size(); i++)
+		{
+			if (commands[i].type == DRAW_TEXT)
+				commands[i].textIndex += stringOffset;
+		}
+	}
+}
+
+// the onscreen area a command draws to, or false if it can't be known ahead of time
+static bool commandBounds(const DrawCommand& cmd, CST_Rect* bounds)
+{
+	switch (cmd.type)
+	{
+	case DRAW_TEXTURE:
+		if (cmd.radius != 0)
+			return false; // rotated
+		*bounds = cmd.rect;
+		return true;
+	case DRAW_FILL_RECT:
+	case DRAW_OUTLINE_RECT:
+		*bounds = cmd.rect;
+		return true;
+	case DRAW_LINE:
+	case DRAW_ROUNDED_BOX:
+	case DRAW_ROUNDED_RECT:
+	case DRAW_RECTANGLE:
+	{
+		int x1 = std::min(cmd.rect.x, cmd.rect.w), x2 = std::max(cmd.rect.x, cmd.rect.w);
+		int y1 = std::min(cmd.rect.y, cmd.rect.h), y2 = std::max(cmd.rect.y, cmd.rect.h);
+		*bounds = { x1, y1, x2 - x1 + 1, y2 - y1 + 1 };
+		return true;
+	}
+	case DRAW_CIRCLE:
+		*bounds = { cmd.rect.x - cmd.radius, cmd.rect.y - cmd.radius, cmd.radius * 2 + 1, cmd.radius * 2 + 1 };
+		return true;
+	default:
+		return false;
+	}
+}
+
+void DisplayList::replay(CST_Renderer* renderer, const CST_Rect* clip) const
+{
+	for (const auto& cmd : commands)
+	{
+		CST_Rect bounds;
+		if (clip && commandBounds(cmd, &bounds) && !CST_HasIntersection(&bounds, clip))
+			continue;
+
+		const auto& c = cmd.color;
+		CST_Rect rect = cmd.rect;
+
+		switch (cmd.type)
+		{
+		case DRAW_TEXTURE:
+		{
+			auto texture = (CST_Texture*)cmd.resource;
+			CST_Rect src = cmd.src;
+			CST_Rect* srcPtr = cmd.hasSrc ? &src : NULL;
+			if (cmd.radius != 0)
+				CST_RenderCopyRotate(renderer, texture, srcPtr, &rect, cmd.radius, c.a);
+			else if (c.r != 0xff || c.g != 0xff || c.b != 0xff || c.a != 0xff)
+				CST_RenderCopyTinted(renderer, texture, srcPtr, &rect, c);
+			else
+				CST_RenderCopy(renderer, texture, srcPtr, &rect);
+			break;
+		}
+		case DRAW_FILL_RECT:
+		case DRAW_OUTLINE_RECT:
+			CST_SetDrawBlend(renderer, cmd.blend);
+			CST_SetDrawColorRGBA(renderer, c.r, c.g, c.b, c.a);
+			if (cmd.type == DRAW_FILL_RECT)
+				CST_FillRect(renderer, &rect);
+			else
+				CST_DrawRect(renderer, &rect);
+			break;
+		case DRAW_LINE:
+			CST_SetDrawBlend(renderer, cmd.blend);
+			CST_SetDrawColorRGBA(renderer, c.r, c.g, c.b, c.a);
+			CST_DrawLine(renderer, rect.x, rect.y, rect.w, rect.h);
+			break;
+		case DRAW_ROUNDED_BOX:
+			CST_roundedBoxRGBA(renderer, rect.x, rect.y, rect.w, rect.h, cmd.radius, c.r, c.g, c.b, c.a);
+			break;
+		case DRAW_ROUNDED_RECT:
+			CST_roundedRectangleRGBA(renderer, rect.x, rect.y, rect.w, rect.h, cmd.radius, c.r, c.g, c.b, c.a);
+			break;
+		case DRAW_RECTANGLE:
+			CST_rectangleRGBA(renderer, rect.x, rect.y, rect.w, rect.h, c.r, c.g, c.b, c.a);
+			break;
+		case DRAW_CIRCLE:
+			CST_filledCircleRGBA(renderer, rect.x, rect.y, cmd.radius, c.r, c.g, c.b, c.a);
+			break;
+		case DRAW_TEXT:
+			CST_DrawFont((CST_Font*)cmd.resource, renderer, rect.x, rect.y, "%s", strings[cmd.textIndex].c_str());
+			break;
+		}
+	}
+}
+
+void DisplayList::addTexture(CST_Texture* texture, CST_Rect* src, CST_Rect* dest, int angle, CST_Color colorMod)
+{
+	if (!texture || !dest)
+		return;
+
+	DrawCommand cmd = {};
+	cmd.type = DRAW_TEXTURE;
+	cmd.resource = texture;
+	cmd.rect = *dest;
+	cmd.hasSrc = src != NULL;
+	if (src)
+		cmd.src = *src;
+	cmd.radius = angle;
+	cmd.color = colorMod;
+	commands.push_back(cmd);
+}
+
+void DisplayList::addRect(DrawCommandType type, CST_Rect* rect)
+{
+	DrawCommand cmd = {};
+	cmd.type = type;
+	cmd.blend = recordBlend;
+	cmd.color = recordColor;
+
+	// a NULL rect means the whole target
+	if (rect)
+		cmd.rect = *rect;
+	else
+		cmd.rect = { 0, 0, 0x7fff, 0x7fff };
+
+	commands.push_back(cmd);
+}
+
+void DisplayList::addLine(int x1, int y1, int x2, int y2)
+{
+	DrawCommand cmd = {};
+	cmd.type = DRAW_LINE;
+	cmd.blend = recordBlend;
+	cmd.color = recordColor;
+	cmd.rect = { x1, y1, x2, y2 };
+	commands.push_back(cmd);
+}
+
+void DisplayList::addPrimitive(DrawCommandType type, int x1, int y1, int x2, int y2, int radius, CST_Color color)
+{
+	DrawCommand cmd = {};
+	cmd.type = type;
+	cmd.color = color;
+	cmd.radius = radius;
+	cmd.rect = { x1, y1, x2, y2 };
+	commands.push_back(cmd);
+}
+
+void DisplayList::addText(CST_Font* font, float x, float y, const char* text)
+{
+	DrawCommand cmd = {};
+	cmd.type = DRAW_TEXT;
+	cmd.resource = font;
+	cmd.rect = { (int)x, (int)y, 0, 0 };
+	cmd.textIndex = (int)strings.size();
+	strings.push_back(text);
+	commands.push_back(cmd);
+}
+
+} // namespace Chesto
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "DrawUtils.hpp"
+
+#include <vector>
+#include <string>
+
+namespace Chesto {
+
+enum DrawCommandType
+{
+	DRAW_TEXTURE,
+	DRAW_FILL_RECT,
+	DRAW_OUTLINE_RECT,
+	DRAW_LINE,
+	DRAW_ROUNDED_BOX,
+	DRAW_ROUNDED_RECT,
+	DRAW_RECTANGLE,
+	DRAW_CIRCLE,
+	DRAW_TEXT,
+};
+
+/// A single recorded drawing call, with all the state it needs to be replayed
+struct DrawCommand
+{
+	DrawCommandType type;
+
+	/// whether blending was enabled (for fills and lines)
+	bool blend;
+
+	/// whether src is used (for textures)
+	bool hasSrc;
+
+	/// the draw color, or the color mod for textures
+	CST_Color color;
+
+	/// corner or circle radius, or rotation angle for textures
+	int radius;
+
+	/// destination rect (for lines and primitives, x/y/w/h hold x1/y1/x2/y2)
+	CST_Rect rect;
+
+	/// source rect within the texture
+	CST_Rect src;
+
+	/// the texture or font being drawn
+	void* resource;
+
+	/// index into the display list's strings (for text)
+	int textIndex;
+};
+
+/**
+ * A DisplayList is a flat list of draw commands, recorded by rendering an Element tree.
+ * While a list is being recorded, the CST_* drawing functions append to it instead of drawing.
+ * Replaying the list issues the same calls again without visiting any Elements.
+ */
+class DisplayList
+{
+public:
+	/// remove all recorded commands
+	void clear();
+
+	/// append all the commands of another list to the end of this one
+	void append(const DisplayList& other);
+
+	/// draw every command in order, skipping any outside of the given clip rect (if not NULL)
+	void replay(CST_Renderer* renderer, const CST_Rect* clip = NULL) const;
+
+	void addTexture(CST_Texture* texture, CST_Rect* src, CST_Rect* dest, int angle, CST_Color colorMod);
+	void addRect(DrawCommandType type, CST_Rect* rect);
+	void addLine(int x1, int y1, int x2, int y2);
+	void addPrimitive(DrawCommandType type, int x1, int y1, int x2, int y2, int radius, CST_Color color);
+	void addText(CST_Font* font, float x, float y, const char* text);
+
+	std::vector<DrawCommand> commands;
+	std::vector<std::string> strings;
+
+	/// the list currently being recorded into (if any)
+	static DisplayList* recording;
+
+	/// the draw state as of the last recorded color/blend change
+	static CST_Color recordColor;
+	static bool recordBlend;
+
+	/// bumped whenever something may have changed anywhere, so that every list gets re-recorded
+	static int generation;
+	static void invalidateAll() { generation++; }
+};
+
+} // namespace Chesto
@@ -1,4 +1,5 @@
 #include "DownloadQueue.hpp"
+#include "Trace.hpp"
 
 namespace Chesto {
 
@@ -157,6 +158,8 @@ void DownloadQueue::startTransfersFromQueue()
 // process finished and queued downloads
 int DownloadQueue::process()
 {
+	TRACE_ZONE("DownloadQueue::process");
+
 #ifndef NETWORK_MOCK
 	DownloadOperation *download;
 	int still_alive = 1;
@@ -185,7 +188,10 @@ int DownloadQueue::process()
 		else
 			download->status = DownloadStatus::FAILED;
 
-		download->cb(download);
+		{
+			TRACE_ZONE_DETAIL("download callback", download->url);
+			download->cb(download);
+		}
 	}
 
 	startTransfersFromQueue();
@@ -7,15 +7,177 @@
 // responsible for directly interacting with SDL!
 #include "DrawUtils.hpp"
 #include "RootDisplay.hpp"
+#include "DisplayList.hpp"
+#include "Trace.hpp"
+#include "PerfOverlay.hpp"
+
+#include <stdarg.h>
 
 namespace Chesto {
 
+static const CST_Color noColorMod = { 0xff, 0xff, 0xff, 0xff };
+
+// the last texture drawn, to count how often the renderer has to switch between them
+static CST_Texture* lastDrawnTexture = NULL;
+
+// count a draw call that's about to be sent to SDL, for the perf overlay
+static void countDrawCall(CST_Texture* texture)
+{
+	PerfOverlay::stats.drawCalls++;
+	if (texture && texture != lastDrawnTexture)
+		PerfOverlay::stats.textureBinds++;
+	lastDrawnTexture = texture;
+}
+
+// SDL_RenderGeometry (needed to batch quads together) was added in 2.0.18
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define CST_BATCHING
+#endif
+
+// past this many pending batches, they're all flushed rather than searched
+#define MAX_PENDING_BATCHES 16
+
+#ifdef CST_BATCHING
+// a run of quads that can be drawn with a single SDL_RenderGeometry call
+struct QuadBatch
+{
+	CST_Renderer* renderer;
+	CST_Texture* texture; // NULL for solid fills
+	SDL_BlendMode blend;  // only used for solid fills, textures use their own
+	CST_Rect bounds;      // union of every quad, to check whether later batches overlap
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+};
+
+// batches are reused between flushes, so their vertex arrays don't need to be reallocated
+static std::vector<QuadBatch> pendingBatches;
+static size_t usedBatches = 0;
+
+// the draw state as last set through CST_*, for solid fills
+static CST_Color batchDrawColor = { 0, 0, 0, 0xff };
+static SDL_BlendMode batchDrawBlend = SDL_BLENDMODE_NONE;
+
+static void queueQuad(
+	CST_Renderer* renderer, CST_Texture* texture, SDL_BlendMode blend,
+	const CST_Rect& dest, float u1, float v1, float u2, float v2, CST_Color color)
+{
+	// look back for a batch with the same state, which this quad can join as long as
+	// no batch after it overlaps (otherwise the draw order would change)
+	QuadBatch* batch = NULL;
+	for (size_t i = usedBatches; i-- > 0;)
+	{
+		QuadBatch& prev = pendingBatches[i];
+		if (prev.renderer == renderer && prev.texture == texture && (texture || prev.blend == blend))
+		{
+			batch = &prev;
+			break;
+		}
+		if (CST_HasIntersection(&prev.bounds, &dest))
+			break;
+	}
+
+	if (batch)
+		CST_UnionRect(&batch->bounds, &dest, &batch->bounds);
+	else
+	{
+		if (usedBatches >= MAX_PENDING_BATCHES)
+			CST_FlushBatches();
+
+		if (pendingBatches.size() <= usedBatches)
+			pendingBatches.emplace_back();
+
+		batch = &pendingBatches[usedBatches++];
+		batch->renderer = renderer;
+		batch->texture = texture;
+		batch->blend = blend;
+		batch->bounds = dest;
+		batch->vertices.clear();
+		batch->indices.clear();
+	}
+
+	float x1 = dest.x, y1 = dest.y;
+	float x2 = dest.x + dest.w, y2 = dest.y + dest.h;
+	SDL_Color c = { color.r, color.g, color.b, color.a };
+
+	int base = (int)batch->vertices.size();
+	batch->vertices.push_back({ { x1, y1 }, c, { u1, v1 } });
+	batch->vertices.push_back({ { x2, y1 }, c, { u2, v1 } });
+	batch->vertices.push_back({ { x1, y2 }, c, { u1, v2 } });
+	batch->vertices.push_back({ { x2, y2 }, c, { u2, v2 } });
+
+	int quad[6] = { base, base + 1, base + 2, base + 2, base + 1, base + 3 };
+	batch->indices.insert(batch->indices.end(), quad, quad + 6);
+}
+
+// queue a texture copy, returns false if it has to be drawn directly instead
+static bool queueTexture(CST_Renderer* renderer, CST_Texture* texture, CST_Rect* src_rect, CST_Rect* dest_rect, CST_Color color)
+{
+	if (!RootDisplay::batchRendering || !texture || !dest_rect)
+		return false;
+
+	float u1 = 0, v1 = 0, u2 = 1, v2 = 1;
+	if (src_rect)
+	{
+		int w, h;
+		if (SDL_QueryTexture(texture, NULL, NULL, &w, &h) != 0 || w <= 0 || h <= 0)
+			return false;
+		u1 = src_rect->x / (float)w;
+		v1 = src_rect->y / (float)h;
+		u2 = (src_rect->x + src_rect->w) / (float)w;
+		v2 = (src_rect->y + src_rect->h) / (float)h;
+	}
+
+	queueQuad(renderer, texture, SDL_BLENDMODE_NONE, *dest_rect, u1, v1, u2, v2, color);
+	return true;
+}
+#endif
+
+void CST_FlushBatches()
+{
+#ifdef CST_BATCHING
+	for (size_t i = 0; i < usedBatches; i++)
+	{
+		QuadBatch& batch = pendingBatches[i];
+
+		// untextured geometry uses the renderer's blend mode
+		if (!batch.texture)
+			SDL_SetRenderDrawBlendMode(batch.renderer, batch.blend);
+
+		countDrawCall(batch.texture);
+		SDL_RenderGeometry(batch.renderer, batch.texture,
+			batch.vertices.data(), (int)batch.vertices.size(),
+			batch.indices.data(), (int)batch.indices.size());
+
+		if (!batch.texture)
+			SDL_SetRenderDrawBlendMode(batch.renderer, batchDrawBlend);
+	}
+	usedBatches = 0;
+#endif
+}
+
 char* musicData = NULL;
 
 bool CST_DrawInit(RootDisplay* root)
 {
 	int sdl2Flags = SDL_INIT_GAMECONTROLLER;
 
+	if (getenv("CHESTO_HEADLESS"))
+		RootDisplay::headless = true;
+
+	if (RootDisplay::headless)
+	{
+		// no display or sound device is needed. older SDL2 releases only read the drivers from the environment
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+		SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+#ifdef SDL_HINT_VIDEODRIVER
+		SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+#endif
+#ifdef SDL_HINT_AUDIODRIVER
+		SDL_SetHint(SDL_HINT_AUDIODRIVER, "dummy");
+#endif
+		SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+	}
+
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_AUDIO | sdl2Flags) < 0)
 	{
 		printf("Failed to initialize SDL2 drawing library: %s\n", SDL_GetError());
@@ -32,8 +194,17 @@ bool CST_DrawInit(RootDisplay* root)
 	int SDLFlags = 0;
 	int windowFlags = 0;
 
-	SDLFlags |= SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC;
-	windowFlags |= SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI;
+	if (RootDisplay::headless)
+	{
+		// the dummy driver's window is just a framebuffer in memory, which the software renderer draws into
+		SDLFlags |= SDL_RENDERER_SOFTWARE;
+		windowFlags |= SDL_WINDOW_HIDDEN;
+	}
+	else
+	{
+		SDLFlags |= SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC;
+		windowFlags |= SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI;
+	}
 
 	root->window = SDL_CreateWindow(
 		NULL, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
@@ -135,6 +306,7 @@ void CST_GetRGBA(Uint32 pixel, SDL_PixelFormat* format, CST_Color* cstColor)
 bool CST_SavePNG(CST_Texture* texture, const char* file_name)
 {
 	auto renderer = RootDisplay::mainDisplay->renderer;
+    CST_FlushBatches();
     SDL_Texture* target = SDL_GetRenderTarget(renderer);
     SDL_SetRenderTarget(renderer, texture);
 	printf("Error: %s\n", SDL_GetError());
@@ -162,6 +334,8 @@ void CST_FadeInMusic(RootDisplay* root)
 
 void CST_RenderPresent(CST_Renderer* renderer)
 {
+	TRACE_ZONE("present");
+
 #ifdef _3DS_MOCK
 	// draw some borders around parts of the 3ds screen
 	CST_SetDrawColorRGBA(renderer, 0, 0, 0, 255);
@@ -173,6 +347,7 @@ void CST_RenderPresent(CST_Renderer* renderer)
 	CST_DrawRect(renderer, &rect3);
 #endif
 
+	CST_FlushBatches();
 	SDL_RenderPresent(renderer);
 }
 
@@ -183,12 +358,58 @@ void CST_FreeSurface(CST_Surface* surface)
 
 void CST_RenderCopy(CST_Renderer* dest, CST_Texture* src, CST_Rect* src_rect, CST_Rect* dest_rect)
 {
+	if (DisplayList::recording) {
+		DisplayList::recording->addTexture(src, src_rect, dest_rect, 0, noColorMod);
+		return;
+	}
+
+#ifdef CST_BATCHING
+	if (queueTexture(dest, src, src_rect, dest_rect, noColorMod))
+		return;
+#endif
+
+	CST_FlushBatches();
+	countDrawCall(src);
 	SDL_RenderCopy(dest, src, src_rect, dest_rect);
 }
 
-void CST_RenderCopyRotate(CST_Renderer* dest, CST_Texture* src, CST_Rect* src_rect, CST_Rect* dest_rect, int angle)
+void CST_RenderCopyRotate(CST_Renderer* dest, CST_Texture* src, CST_Rect* src_rect, CST_Rect* dest_rect, int angle, uint8_t alpha)
 {
+	if (DisplayList::recording) {
+		DisplayList::recording->addTexture(src, src_rect, dest_rect, angle, { 0xff, 0xff, 0xff, alpha });
+		return;
+	}
+
+	CST_FlushBatches();
+	countDrawCall(src);
+	if (alpha != 0xff)
+		SDL_SetTextureAlphaMod(src, alpha);
 	SDL_RenderCopyEx(dest, src, src_rect, dest_rect, angle, NULL, SDL_FLIP_NONE);
+	if (alpha != 0xff)
+		SDL_SetTextureAlphaMod(src, 0xFF);
+}
+
+void CST_RenderCopyTinted(CST_Renderer* dest, CST_Texture* src, CST_Rect* src_rect, CST_Rect* dest_rect, CST_Color colorMod)
+{
+	if (DisplayList::recording) {
+		DisplayList::recording->addTexture(src, src_rect, dest_rect, 0, colorMod);
+		return;
+	}
+
+#ifdef CST_BATCHING
+	// when batched, the color mod is applied through the vertex colors instead
+	if (queueTexture(dest, src, src_rect, dest_rect, colorMod))
+		return;
+#endif
+
+	// render the texture with a color and alpha mod (which can only darken or fade it), and then reset them
+	CST_FlushBatches();
+	countDrawCall(src);
+	SDL_SetTextureColorMod(src, colorMod.r, colorMod.g, colorMod.b);
+	SDL_SetTextureAlphaMod(src, colorMod.a);
+	SDL_RenderCopy(dest, src, src_rect, dest_rect);
+	SDL_SetTextureColorMod(src, 0xFF, 0xFF, 0xFF);
+	SDL_SetTextureAlphaMod(src, 0xFF);
 }
 
 void CST_SetDrawColor(CST_Renderer* renderer, CST_Color c)
@@ -198,30 +419,158 @@ void CST_SetDrawColor(CST_Renderer* renderer, CST_Color c)
 
 void CST_SetDrawColorRGBA(CST_Renderer* renderer, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 {
+	if (DisplayList::recording) {
+		DisplayList::recordColor = { r, g, b, a };
+		return;
+	}
+
+#ifdef CST_BATCHING
+	batchDrawColor = { r, g, b, a };
+#endif
+
 	SDL_SetRenderDrawColor(renderer, r, g, b, a);
 }
 
 void CST_FillRect(CST_Renderer* renderer, CST_Rect* dimens)
 {
+	if (DisplayList::recording) {
+		DisplayList::recording->addRect(DRAW_FILL_RECT, dimens);
+		return;
+	}
+
+#ifdef CST_BATCHING
+	if (RootDisplay::batchRendering && dimens)
+	{
+		queueQuad(renderer, NULL, batchDrawBlend, *dimens, 0, 0, 0, 0, batchDrawColor);
+		return;
+	}
+#endif
+
+	CST_FlushBatches();
+	countDrawCall(NULL);
 	SDL_RenderFillRect(renderer, dimens);
 }
 
 void CST_DrawRect(CST_Renderer* renderer, CST_Rect* dimens)
 {
+	if (DisplayList::recording) {
+		DisplayList::recording->addRect(DRAW_OUTLINE_RECT, dimens);
+		return;
+	}
+
+	CST_FlushBatches();
+	countDrawCall(NULL);
 	SDL_RenderDrawRect(renderer, dimens);
 }
 
 void CST_DrawLine(CST_Renderer* renderer, int x, int y, int w, int h)
 {
+	if (DisplayList::recording) {
+		DisplayList::recording->addLine(x, y, w, h);
+		return;
+	}
+
+	CST_FlushBatches();
+	countDrawCall(NULL);
 	SDL_RenderDrawLine(renderer, x, y, w, h);
 }
 
+void CST_SetClipRect(CST_Renderer* renderer, CST_Rect* rect)
+{
+	CST_FlushBatches();
+	SDL_RenderSetClipRect(renderer, rect);
+}
+
+CST_Texture* CST_CreateTargetTexture(CST_Renderer* renderer, int w, int h)
+{
+	// not every platform's renderer can draw into textures
+	if (!SDL_RenderTargetSupported(renderer))
+		return NULL;
+
+	return SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+}
+
+CST_Texture* CST_GetRenderTarget(CST_Renderer* renderer)
+{
+	return SDL_GetRenderTarget(renderer);
+}
+
+void CST_SetTextureBlend(CST_Texture* texture, bool enabled)
+{
+	SDL_SetTextureBlendMode(texture, enabled ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+}
+
+// blend a texture whose colors are already multiplied by its alpha, like a target texture that was cleared
+// to transparent and drawn into with blending. returns false if the renderer can't
+bool CST_SetTexturePremultiplied(CST_Texture* texture)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+	SDL_BlendMode mode = SDL_ComposeCustomBlendMode(
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+	return SDL_SetTextureBlendMode(texture, mode) == 0;
+#else
+	return false;
+#endif
+}
+
+void CST_SetRenderTarget(CST_Renderer* renderer, CST_Texture* target)
+{
+	CST_FlushBatches();
+	SDL_SetRenderTarget(renderer, target);
+}
+
+void CST_DestroyTexture(CST_Texture* texture)
+{
+	// a pending batch may still refer to it
+	CST_FlushBatches();
+	SDL_DestroyTexture(texture);
+}
+
+bool CST_HasIntersection(const CST_Rect* a, const CST_Rect* b)
+{
+	return SDL_HasIntersection(a, b);
+}
+
+void CST_UnionRect(const CST_Rect* a, const CST_Rect* b, CST_Rect* result)
+{
+	SDL_UnionRect(a, b, result);
+}
+
 void CST_SetDrawBlend(CST_Renderer* renderer, bool enabled)
 {
+	if (DisplayList::recording) {
+		DisplayList::recordBlend = enabled;
+		return;
+	}
+
 	SDL_BlendMode mode = enabled ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE;
+#ifdef CST_BATCHING
+	batchDrawBlend = mode;
+#endif
 	SDL_SetRenderDrawBlendMode(renderer, mode);
 }
 
+FC_Rect CST_DrawFont(CST_Font* font, CST_Renderer* renderer, float x, float y, const char* formatted_text, ...)
+{
+	char buffer[1024];
+	va_list args;
+	va_start(args, formatted_text);
+	vsnprintf(buffer, sizeof(buffer), formatted_text, args);
+	va_end(args);
+
+	if (DisplayList::recording) {
+		DisplayList::recording->addText(font, x, y, buffer);
+		return FC_MakeRect(x, y, FC_GetWidth(font, "%s", buffer), FC_GetHeight(font, "%s", buffer));
+	}
+
+	// the font cache draws from its own glyph texture
+	CST_FlushBatches();
+	countDrawCall(NULL);
+	PerfOverlay::stats.textureBinds++;
+	return FC_Draw(font, renderer, x, y, "%s", buffer);
+}
+
 void CST_QueryTexture(CST_Texture* texture, int* w, int* h)
 {
 	SDL_QueryTexture(texture, nullptr, nullptr, w, h);
@@ -239,6 +588,15 @@ void CST_SetQualityHint(const char* quality)
 
 void CST_filledCircleRGBA(CST_Renderer* renderer, uint32_t x, uint32_t y, uint32_t radius, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
 {
+	if (DisplayList::recording) {
+		DisplayList::recording->addPrimitive(DRAW_CIRCLE, x, y, 0, 0, radius, { (Uint8)r, (Uint8)g, (Uint8)b, (Uint8)a });
+		return;
+	}
+
+	CST_FlushBatches();
+	countDrawCall(NULL);
+	PerfOverlay::stats.gfxCalls++;
+
 	#if !defined(SIMPLE_SDL2)
 	// TODO: filledCircleRGBA needs to take a surface in SIMPLE_SDL2
 	filledCircleRGBA(renderer, x, y, radius, r, g, b, a);
@@ -262,6 +620,11 @@ int CST_GetTicks()
 	return SDL_GetTicks();
 }
 
+double CST_GetPreciseTicks()
+{
+	return SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
 void CST_LowRumble(InputEvents* event, int) // duration unused
 {
 	auto joystick = SDL_JoystickFromInstanceID(event->event.jdevice.which);
@@ -307,6 +670,10 @@ bool CST_isRectOffscreen(CST_Rect* rect)
 // returns the high-dpi scaling factor, by measuring the window size and the drawable size (ratio)
 float CST_GetDpiScale()
 {
+	// there's no display to match
+	if (RootDisplay::headless || !RootDisplay::window)
+		return 1;
+
 	int w, h;
 	SDL_GetWindowSize(RootDisplay::window, &w, &h);
 	int dw, dh;
@@ -324,6 +691,15 @@ void CST_roundedBoxRGBA (
 	Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2,
 	Sint16 rad, Uint8 r, Uint8 g, Uint8 b, Uint8 a
 ) {
+	if (DisplayList::recording) {
+		DisplayList::recording->addPrimitive(DRAW_ROUNDED_BOX, x1, y1, x2, y2, rad, { r, g, b, a });
+		return;
+	}
+
+	CST_FlushBatches();
+	countDrawCall(NULL);
+	PerfOverlay::stats.gfxCalls++;
+
 	#if !defined(SIMPLE_SDL2)
 	// TODO: roundedBoxRGBA needs to take a surface in SIMPLE_SDL2
 	roundedBoxRGBA(renderer, x1, y1, x2, y2, rad, r, g, b, a);
@@ -335,6 +711,15 @@ void CST_roundedRectangleRGBA (
 	Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2,
 	Sint16 rad, Uint8 r, Uint8 g, Uint8 b, Uint8 a
 ) {
+	if (DisplayList::recording) {
+		DisplayList::recording->addPrimitive(DRAW_ROUNDED_RECT, x1, y1, x2, y2, rad, { r, g, b, a });
+		return;
+	}
+
+	CST_FlushBatches();
+	countDrawCall(NULL);
+	PerfOverlay::stats.gfxCalls++;
+
 	#if !defined(SIMPLE_SDL2)
 	// TODO: roundedRectangleRGBA needs to take a surface in SIMPLE_SDL2
 	roundedRectangleRGBA(renderer, x1, y1, x2, y2, rad, r, g, b, a);
@@ -346,6 +731,15 @@ void CST_rectangleRGBA (
 	Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2,
 	Uint8 r, Uint8 g, Uint8 b, Uint8 a
 ) {
+	if (DisplayList::recording) {
+		DisplayList::recording->addPrimitive(DRAW_RECTANGLE, x1, y1, x2, y2, 0, { r, g, b, a });
+		return;
+	}
+
+	CST_FlushBatches();
+	countDrawCall(NULL);
+	PerfOverlay::stats.gfxCalls++;
+
 	#if !defined(SIMPLE_SDL2)
 	// TODO: rectangleRGBA needs to take a surface in SIMPLE_SDL2
 	rectangleRGBA(renderer, x1, y1, x2, y2, r, g, b, a);
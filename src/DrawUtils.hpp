@@ -48,7 +48,11 @@ void CST_RenderPresent(CST_Renderer* render);
 void CST_FreeSurface(CST_Surface* surface);
 
 void CST_RenderCopy(CST_Renderer* dest, CST_Texture* src, CST_Rect* src_rect, CST_Rect* dest_rect);
-void CST_RenderCopyRotate(CST_Renderer* dest, CST_Texture* src, CST_Rect* src_rect, CST_Rect* dest_rect, int angle);
+void CST_RenderCopyRotate(CST_Renderer* dest, CST_Texture* src, CST_Rect* src_rect, CST_Rect* dest_rect, int angle, uint8_t alpha);
+/// draw any quads that have been batched up (only needed before drawing with SDL directly)
+void CST_FlushBatches();
+/// draw a texture multiplied by colorMod, with colorMod.a as its opacity
+void CST_RenderCopyTinted(CST_Renderer* dest, CST_Texture* src, CST_Rect* src_rect, CST_Rect* dest_rect, CST_Color colorMod);
 
 // color analogues
 void CST_SetDrawColor(CST_Renderer* renderer, CST_Color c);
@@ -58,6 +62,19 @@ void CST_DrawRect(CST_Renderer* renderer, CST_Rect* dimens);
 void CST_SetDrawBlend(CST_Renderer* renderer, bool enabled);
 void CST_DrawLine(CST_Renderer* renderer, int x, int y, int w, int h);
 
+// clipping and offscreen target analogues
+void CST_SetClipRect(CST_Renderer* renderer, CST_Rect* rect);
+CST_Texture* CST_CreateTargetTexture(CST_Renderer* renderer, int w, int h);
+CST_Texture* CST_GetRenderTarget(CST_Renderer* renderer);
+void CST_SetRenderTarget(CST_Renderer* renderer, CST_Texture* target);
+void CST_SetTextureBlend(CST_Texture* texture, bool enabled);
+bool CST_SetTexturePremultiplied(CST_Texture* texture);
+void CST_DestroyTexture(CST_Texture* texture);
+
+// rect helpers
+bool CST_HasIntersection(const CST_Rect* a, const CST_Rect* b);
+void CST_UnionRect(const CST_Rect* a, const CST_Rect* b, CST_Rect* result);
+
 void CST_QueryTexture(CST_Texture* texture, int* w, int* h);
 CST_Texture* CST_CreateTextureFromSurface(CST_Renderer* renderer, CST_Surface* surface, bool isAccessible);
 void CST_SetQualityHint(const char* quality);
@@ -80,6 +97,7 @@ void CST_SetWindowSize(CST_Window* renderer, int w, int h);
 void CST_Delay(int time);
 
 int CST_GetTicks();
+double CST_GetPreciseTicks(); // in ms, with sub-ms precision
 bool CST_isRectOffscreen(CST_Rect* rect);
 
 void CST_GetRGBA(Uint32 pixel, SDL_PixelFormat* format, CST_Color* cstColor);
@@ -105,7 +123,7 @@ std::vector<std::string> CST_GetMusicInfo(CST_Music* music);
 #define CST_GetFontLineHeight FC_GetLineHeight
 #define CST_GetFontWidth FC_GetWidth
 #define CST_GetFontHeight FC_GetHeight
-#define CST_DrawFont FC_Draw
+FC_Rect CST_DrawFont(CST_Font* font, CST_Renderer* renderer, float x, float y, const char* formatted_text, ...);
 
 void chdirForPlatform();
 std::string replaceAll(std::string str, const std::string& from, const std::string& to);
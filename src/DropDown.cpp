@@ -1,6 +1,7 @@
 #include "DropDown.hpp"
 #include "Button.hpp"
 #include "Constraint.hpp"
+#include "FocusManager.hpp"
 #include "RootDisplay.hpp"
 #include <iostream>
 
@@ -168,6 +169,9 @@ bool DropDownChoices::process(InputEvents* event) {
 
 	if (event->isTouch()) {
 		// unhighlight whatever may be highlighted
+		if (curHighlighted >= 0 && curHighlighted < (int)container->elements.size()
+			&& FocusManager::getFocus() == container->elements[curHighlighted].get())
+			FocusManager::setFocus(NULL);
 		this->curHighlighted = -1;
 	} else {
 		if (event->isKeyDown() && event->held(UP_BUTTON | DOWN_BUTTON | LEFT_BUTTON | RIGHT_BUTTON)) {
@@ -187,7 +191,10 @@ bool DropDownChoices::process(InputEvents* event) {
 
 			// highlight the new element
 			if (curHighlighted < (int)container->elements.size() && container->elements[curHighlighted])
+			{
 				container->elements[curHighlighted]->elasticCounter = THICK_HIGHLIGHT;
+				FocusManager::setFocus(container->elements[curHighlighted].get());
+			}
 
 			// Auto-scroll to keep highlighted element on screen (similar to AppList logic)
 			if (curHighlighted >= 0 && curHighlighted < (int)container->elements.size() && container->elements[curHighlighted] && scrollList) {
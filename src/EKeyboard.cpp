@@ -1,4 +1,5 @@
 #include "EKeyboard.hpp"
+#include "FocusManager.hpp"
 
 namespace Chesto {
 
@@ -23,6 +24,9 @@ EKeyboard::EKeyboard(std::function<void(char)> typeAction)
 
 	// position the EKeyboard based on this x and y
 	updateSize();
+
+	// keyboard input should reach us even when something else is focused
+	FocusManager::addListener(this);
 }
 
 void EKeyboard::render(Element*)
@@ -2,14 +2,30 @@
 #include <algorithm>
 #include "Constraint.hpp"
 #include "Animation.hpp"
+#include "Clock.hpp"
+#include "DisplayList.hpp"
+#include "PerfOverlay.hpp"
+#include "TouchIndex.hpp"
+#include "FocusManager.hpp"
+#include "ConstraintGraph.hpp"
+#include "RedrawTrace.hpp"
 #include <string>
+#include <cmath>
 
 namespace Chesto {
 
 // Shared deleter for all elements - respects isProtected flag
-static void safeElementDeleter(Element* elem) {
+void ElementDeleter::operator()(Element* elem) const {
 	if (elem && !elem->isProtected) {
-		delete elem;
+		if (elem->arena) {
+			// the arena needs the start of the whole object, which may not be where its Element part is
+			ElementArena* arena = elem->arena;
+			void* memory = dynamic_cast<void*>(elem);
+			elem->~Element();
+			arena->release(memory);
+		} else {
+			delete elem;
+		}
 	}
 }
 
@@ -18,7 +34,15 @@ Element::~Element()
 	// unique_ptrs will automatically cleaned up
 	elements.clear();
 	constraints.clear();
-	animations.clear();
+	AnimationTimeline::cancelAll(this);
+	releaseLayer();
+	TouchIndex::remove(this);
+
+	if (isFocusListener || FocusManager::getFocus() == this)
+		FocusManager::forget(this);
+
+	// the layout graph may still point to us
+	ConstraintGraph::structureSerial++;
 }
 
 Element::Element()
@@ -44,7 +68,7 @@ bool Element::process(InputEvents* event)
 #endif
 
 	// do any touch down, drag, or up events
-	if (touchable)
+	if (touchable && isTouchCandidate())
 	{
 		ret |= onTouchDown(event);
 		ret |= onTouchDrag(event);
@@ -52,6 +76,14 @@ bool Element::process(InputEvents* event)
 		// if an action would modify or free elements before TouchUp fires, use RootDisplay::deferAction instead
 	}
 
+	// a highlight change from touch events only affects our own area
+	if (ret)
+	{
+		markDamaged();
+		if (RootDisplay::traceRedraws)
+			RedrawTrace::add(this, REDRAW_TOUCH);
+	}
+
 	// call process on subelements
 	size_t elementCount = this->elements.size();
 	for (size_t x = 0; x < elementCount; x++)
@@ -59,9 +91,39 @@ bool Element::process(InputEvents* event)
 		// ensure element still exists before trying to process it
 		if (x < this->elements.size() && this->elements[x])
 		{
+			// routed key events only go to children on the path to a focused element or listener
+			if (FocusManager::routing && this->elements[x]->focusRouteSerial != FocusManager::routeSerial)
+				continue;
+
+			// events with no input only do background work, which isn't needed for anything offscreen
+			if (event->noop && RootDisplay::cullSubtrees && this->elements[x]->subtreeExtentValid)
+			{
+				this->elements[x]->recalcPosition(this);
+				if (this->elements[x]->isSubtreeCulled())
+					continue;
+			}
+
+			int damageSerial = RootDisplay::damageSerial;
+			size_t causes = RootDisplay::traceRedraws ? RedrawTrace::count() : 0;
 			bool childHandled = this->elements[x]->process(event);
 			ret |= childHandled;
 
+			// the child changed something without saying where, so everything has to be redrawn
+			if (childHandled && damageSerial == RootDisplay::damageSerial)
+				RootDisplay::addFullDamage();
+
+			// the child may not have gone through Element::process, so make sure it gets re-recorded
+			if (childHandled && x < this->elements.size() && this->elements[x])
+			{
+				this->elements[x]->displayListDirty = true;
+				this->elements[x]->layerDirty = true;
+				this->elements[x]->subtreeExtentValid = false;
+
+				// nothing further down said why, so it was the child's own process override
+				if (RootDisplay::traceRedraws && RedrawTrace::count() == causes)
+					RedrawTrace::add(this->elements[x].get(), REDRAW_PROCESS);
+			}
+
 			if (childHandled && this->elements.size() != elementCount) {
 				// size changed while we were processing, break out
 				break;
@@ -69,21 +131,38 @@ bool Element::process(InputEvents* event)
 		}
 	}
 
-	ret |= this->needsRedraw;
+	bool selfChanged = this->needsRedraw;
 	this->needsRedraw = false;
+	if (selfChanged && RootDisplay::traceRedraws)
+		RedrawTrace::add(this, tweened ? REDRAW_TWEEN : REDRAW_NEEDS_REDRAW);
+	tweened = false;
 
 	// if this variable is positive, decrease it, and force a redraw (acts like needsRedraw but over X redraws)
 	if (futureRedrawCounter > 0) {
 		futureRedrawCounter --;
-		ret |= true;
+		selfChanged = true;
+		if (RootDisplay::traceRedraws)
+			RedrawTrace::add(this, REDRAW_FUTURE_COUNTER);
 	}
 
 	if (RootDisplay::idleCursorPulsing) {
 		// if we are using idle cursor pulsing, and this element's elastic counter is 0, force a redraw
-		return ret | (this->elasticCounter > 0);
+		selfChanged |= (this->elasticCounter > 0);
+		if (this->elasticCounter > 0 && RootDisplay::traceRedraws)
+			RedrawTrace::add(this, REDRAW_ELASTIC_COUNTER);
 	}
 
-	return ret;
+	if (selfChanged)
+		markDamaged();
+
+	if (ret || selfChanged)
+	{
+		displayListDirty = true;
+		layerDirty = true;
+		subtreeExtentValid = false;
+	}
+
+	return ret | selfChanged;
 }
 
 void Element::render(Element* parent)
@@ -91,9 +170,21 @@ void Element::render(Element* parent)
 	//if we're hidden, don't render
 	if (hidden) return;
 
+	PerfOverlay::stats.visited++;
+
 	// this needs to happen before any rendering
 	this->recalcPosition(parent);
 
+	// outside of the region being redrawn, only our children may need drawing
+	if (!isInDamage())
+	{
+		for (auto& subelement : elements)
+		{
+			renderChild(subelement.get());
+		}
+		return;
+	}
+
 	// if we're in debug mode, draw an outline
 	if (this->hasBackground) {
 		// render the element background
@@ -107,7 +198,7 @@ void Element::render(Element* parent)
 	// go through every subelement and run render
 	for (auto& subelement : elements)
 	{
-		subelement->render(this);
+		renderChild(subelement.get());
 	}
 
 	CST_Renderer* renderer = getRenderer();
@@ -142,7 +233,7 @@ void Element::render(Element* parent)
 		CST_Rect d = { this->xAbs - marginSpacing, this->yAbs - marginSpacing, scaledWidth + marginSpacing*2, scaledHeight + marginSpacing*2 };
 		if (this->elasticCounter == THICK_HIGHLIGHT)
 		{
-			int ticks = CST_GetTicks() / 100;
+			int ticks = Clock::now() / 100;
 			int pulseState = ticks % 20;
 			if (pulseState > 9) {
 				pulseState = 19 - pulseState;
@@ -174,7 +265,64 @@ void Element::render(Element* parent)
 	}
 }
 
+static bool sameLayoutInputs(const Element::LayoutInputs& a, const Element::LayoutInputs& b)
+{
+	return a.parent == b.parent && a.parentSerial == b.parentSerial
+		&& a.targetSerials == b.targetSerials && a.generation == b.generation
+		&& a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height
+		&& a.scale == b.scale && a.globalScale == b.globalScale && a.angle == b.angle
+		&& a.isAbsolute == b.isAbsolute && a.touchable == b.touchable
+		&& a.constraintCount == b.constraintCount;
+}
+
+Element::LayoutInputs Element::getLayoutInputs(Element* parent)
+{
+	// constraint targets are read directly, so any of them changing means we have to update too
+	int targetSerials = 0;
+	for (auto& constraint : constraints)
+	{
+		for (Element* target : constraint->targets)
+			targetSerials = targetSerials * 31 + target->layoutSerial;
+	}
+
+	LayoutInputs inputs;
+	inputs.parent = parent;
+	inputs.parentSerial = parent ? parent->layoutSerial : 0;
+	inputs.targetSerials = targetSerials;
+	inputs.generation = RootDisplay::layoutGeneration;
+	inputs.x = x;
+	inputs.y = y;
+	inputs.width = width;
+	inputs.height = height;
+	inputs.scale = scale;
+	inputs.globalScale = RootDisplay::globalScale;
+	inputs.angle = angle;
+	inputs.isAbsolute = isAbsolute;
+	inputs.touchable = touchable;
+	inputs.constraintCount = constraints.size();
+	return inputs;
+}
+
+ElementArena* Element::getArena()
+{
+	if (arena)
+		return arena;
+
+	return parent ? parent->getArena() : NULL;
+}
+
+void Element::invalidateLayout()
+{
+	layoutValid = false;
+}
+
 void Element::recalcPosition(Element* parent) {
+	// nothing we're positioned from has changed, so xAbs and yAbs are still correct
+	if (RootDisplay::cacheLayout && layoutValid && sameLayoutInputs(getLayoutInputs(parent), layoutInputs))
+		return;
+
+	int lastXAbs = xAbs, lastYAbs = yAbs;
+
 	// go through all constraints and apply them
 	for (auto& constraint : constraints)
 	{
@@ -199,25 +347,58 @@ void Element::recalcPosition(Element* parent) {
 		this->yAbs = this->y;
 	}
 
-	// go through all animations and apply them
-	if (animations.size() > 0) {
-		std::vector<size_t> toRemove;
-		for (size_t i = 0; i < animations.size(); i++)
+	if (RootDisplay::partialRedraw)
+	{
+		// if we moved or resized, both where we were and where we are now need redrawing
+		CST_Rect bounds = getDamageBounds();
+		auto& last = lastDamageBounds;
+		if (bounds.x != last.x || bounds.y != last.y || bounds.w != last.w || bounds.h != last.h)
 		{
-			auto& animation = animations[i];
-			// if there are any animations, we need to re-render
-			needsRedraw = true;
-
-			bool finished = animation->step();
-			if (finished) {
-				toRemove.push_back(i);
-			}
+			RootDisplay::addDamage(last);
+			RootDisplay::addDamage(bounds);
+			lastDamageBounds = bounds;
 		}
+	}
 
-		for (auto it = toRemove.rbegin(); it != toRemove.rend(); ++it) {
-			animations.erase(animations.begin() + *it);
+	// moving within our parent changes the extent of every subtree we're in
+	if (RootDisplay::cullSubtrees && parent)
+	{
+		CST_Rect bounds = getDamageBounds();
+		bounds.x -= parent->xAbs;
+		bounds.y -= parent->yAbs;
+		auto& last = relativeBounds;
+		if (bounds.x != last.x || bounds.y != last.y || bounds.w != last.w || bounds.h != last.h)
+		{
+			relativeBounds = bounds;
+			invalidateSubtreeExtent();
 		}
 	}
+
+	// keep our spot in the touch index up to date
+	if (RootDisplay::indexTouches && touchable)
+	{
+		bool wasIndexed = inTouchIndex;
+		CST_Rect cells = touchCells;
+		TouchIndex::update(this, getBounds());
+
+		// the pointer was looked up before we moved, so make sure we still get this event
+		if (!wasIndexed || cells.x != touchCells.x || cells.y != touchCells.y || cells.w != touchCells.w || cells.h != touchCells.h)
+			touchCandidateSerial = TouchIndex::eventSerial;
+	}
+	else if (inTouchIndex)
+		TouchIndex::remove(this);
+
+	if (RootDisplay::cacheLayout)
+	{
+		// let our children and anything constrained to us know that they need to update
+		LayoutInputs inputs = getLayoutInputs(parent);
+		if (!layoutValid || xAbs != lastXAbs || yAbs != lastYAbs || inputs.x != layoutInputs.x || inputs.y != layoutInputs.y
+			|| inputs.width != layoutInputs.width || inputs.height != layoutInputs.height || inputs.scale != layoutInputs.scale)
+			layoutSerial++;
+
+		layoutInputs = inputs;
+		layoutValid = true;
+	}
 }
 
 float Element::getEffectiveScale() const {
@@ -236,19 +417,282 @@ CST_Rect Element::getBounds()
 	};
 }
 
+CST_Rect Element::getDamageBounds()
+{
+	CST_Rect bounds = getBounds();
+
+	// highlights are drawn a few pixels outside of our bounds
+	int margin = touchable ? 8 : 0;
+
+	// rotated elements can extend past their bounds, up to half the diagonal
+	if (angle != 0)
+		margin += (int)(sqrt(bounds.w * bounds.w + bounds.h * bounds.h) - std::min(bounds.w, bounds.h)) / 2 + 1;
+
+	bounds.x -= margin;
+	bounds.y -= margin;
+	bounds.w += margin * 2;
+	bounds.h += margin * 2;
+	return bounds;
+}
+
+void Element::markDamaged()
+{
+	if (!RootDisplay::partialRedraw)
+		return;
+
+	// include both the current area and the last drawn one, in case we were moved
+	RootDisplay::addDamage(lastDamageBounds);
+	RootDisplay::addDamage(getDamageBounds());
+}
+
+bool Element::isInDamage()
+{
+	if (RootDisplay::currentDamage == NULL)
+		return true;
+
+	CST_Rect bounds = getDamageBounds();
+	return CST_HasIntersection(&bounds, RootDisplay::currentDamage);
+}
+
+void Element::renderChild(Element* child)
+{
+	if (child->cacheAsLayer && child->renderCachedLayer(this))
+		return;
+
+	// while recording for retained rendering, reuse the child's own recording if it's still valid
+	if (DisplayList::recording && RootDisplay::retainedRender)
+	{
+		DisplayList::recording->append(*child->compileDisplayList(this));
+		return;
+	}
+
+	// skip the whole subtree if none of it would be drawn
+	if (RootDisplay::cullSubtrees && child->subtreeExtentValid && !child->hidden)
+	{
+		child->recalcPosition(this);
+		if (child->isSubtreeCulled())
+		{
+			PerfOverlay::stats.culled++;
+			return;
+		}
+	}
+
+	child->render(this);
+
+	if (RootDisplay::cullSubtrees)
+		child->updateSubtreeExtent();
+}
+
+void Element::updateSubtreeExtent()
+{
+	CST_Rect extent = getDamageBounds();
+	bool valid = true;
+
+	for (auto& child : elements)
+	{
+		if (!child || child->hidden)
+			continue;
+
+		// a child that wasn't rendered through renderChild doesn't know its extent, so neither do we
+		if (!child->subtreeExtentValid)
+		{
+			valid = false;
+			break;
+		}
+
+		CST_Rect childExtent = child->subtreeExtent;
+		childExtent.x += child->xAbs;
+		childExtent.y += child->yAbs;
+		CST_UnionRect(&extent, &childExtent, &extent);
+	}
+
+	extent.x -= xAbs;
+	extent.y -= yAbs;
+	subtreeExtent = extent;
+	subtreeExtentValid = valid;
+}
+
+void Element::invalidateSubtreeExtent()
+{
+	for (Element* elem = this; elem != NULL; elem = elem->parent)
+		elem->subtreeExtentValid = false;
+}
+
+bool Element::isSubtreeCulled()
+{
+	// display lists are replayed without visiting elements, so they need everything recorded
+	if (!subtreeExtentValid || DisplayList::recording)
+		return false;
+
+	CST_Rect bounds = subtreeExtent;
+	bounds.x += xAbs;
+	bounds.y += yAbs;
+
+	if (CST_isRectOffscreen(&bounds))
+		return true;
+
+	return RootDisplay::currentDamage && !CST_HasIntersection(&bounds, RootDisplay::currentDamage);
+}
+
+DisplayList* Element::compileDisplayList(Element* parent)
+{
+	if (!displayList)
+		displayList = std::make_unique<DisplayList>();
+
+	// the recorded commands use absolute coordinates, so moving also requires a re-record
+	if (parent)
+		this->recalcPosition(parent);
+
+	bool stale = displayListDirty
+		|| recordedX != xAbs || recordedY != yAbs
+		|| recordedGeneration != DisplayList::generation;
+
+	if (stale)
+	{
+		DisplayList* outer = DisplayList::recording;
+		displayList->clear();
+		DisplayList::recording = displayList.get();
+		this->render(parent);
+		DisplayList::recording = outer;
+
+		displayListDirty = false;
+		recordedX = xAbs;
+		recordedY = yAbs;
+		recordedGeneration = DisplayList::generation;
+	}
+
+	return displayList.get();
+}
+
+void Element::invalidateDisplayList()
+{
+	for (Element* elem = this; elem != NULL; elem = elem->parent)
+	{
+		elem->displayListDirty = true;
+		elem->layerDirty = true;
+		elem->subtreeExtentValid = false;
+	}
+}
+
+void Element::requestRedraw()
+{
+	needsRedraw = true;
+	markDamaged();
+	invalidateDisplayList();
+}
+
+bool Element::renderCachedLayer(Element* parent)
+{
+	if (hidden)
+		return true;
+
+	this->recalcPosition(parent);
+
+	CST_Renderer* renderer = getRenderer();
+
+	// the layer covers the whole screen, so that children outside our bounds are kept too
+	if (!layerTexture || layerWidth != SCREEN_WIDTH || layerHeight != SCREEN_HEIGHT)
+	{
+		releaseLayer();
+		layerTexture = CST_CreateTargetTexture(renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+		if (!layerTexture)
+			return false;
+
+		// what's drawn into the layer ends up with its colors already multiplied by its alpha, so blending
+		// it normally would apply translucent parts' alpha twice. without premultiplied blending, draw live
+		if (!CST_SetTexturePremultiplied(layerTexture))
+		{
+			releaseLayer();
+			return false;
+		}
+
+		layerWidth = SCREEN_WIDTH;
+		layerHeight = SCREEN_HEIGHT;
+		layerDirty = true;
+	}
+
+	bool stale = layerDirty
+		|| layerX != xAbs || layerY != yAbs
+		|| layerGeneration != DisplayList::generation;
+
+	if (stale)
+	{
+		// the layer needs everything drawn, not just the damaged region being redrawn, and shouldn't be recorded
+		const CST_Rect* damage = RootDisplay::currentDamage;
+		CST_Rect savedClip = damage ? *damage : CST_Rect{0, 0, 0, 0};
+		DisplayList* recording = DisplayList::recording;
+		CST_Texture* target = CST_GetRenderTarget(renderer);
+
+		RootDisplay::currentDamage = NULL;
+		DisplayList::recording = NULL;
+		CST_SetRenderTarget(renderer, layerTexture);
+		CST_SetClipRect(renderer, NULL);
+
+		// start from fully transparent
+		CST_SetDrawBlend(renderer, false);
+		CST_SetDrawColorRGBA(renderer, 0, 0, 0, 0);
+		CST_FillRect(renderer, NULL);
+
+		this->render(parent);
+
+		CST_SetRenderTarget(renderer, target);
+		RootDisplay::currentDamage = damage;
+		DisplayList::recording = recording;
+		CST_SetClipRect(renderer, damage ? &savedClip : NULL);
+
+		layerDirty = false;
+		layerX = xAbs;
+		layerY = yAbs;
+		layerGeneration = DisplayList::generation;
+	}
+
+	CST_Rect full = { 0, 0, layerWidth, layerHeight };
+	CST_RenderCopy(renderer, layerTexture, NULL, &full);
+	return true;
+}
+
+void Element::releaseLayer()
+{
+	if (layerTexture)
+		CST_DestroyTexture(layerTexture);
+	layerTexture = NULL;
+	layerDirty = true;
+}
+
+void Element::hide()
+{
+	if (!this->hidden)
+	{
+		markDamaged();
+		this->hidden = true;
+		invalidateDisplayList();
+	}
+}
+
+void Element::unhide()
+{
+	if (this->hidden)
+	{
+		this->hidden = false;
+		markDamaged();
+		invalidateDisplayList();
+	}
+}
+
 void Element::renderBackground(bool fill) {
 	CST_Renderer* renderer = getRenderer();
 	CST_Rect bounds = getBounds();
 	auto r = backgroundColor.r * 0xFF;
 	auto g = backgroundColor.g * 0xFF;
 	auto b = backgroundColor.b * 0xFF;
+	int alpha = backgroundOpacity * opacity / 0xFF;
 	
 	if (cornerRadius > 0) {
 		const auto renderRect = fill ? CST_roundedBoxRGBA : CST_roundedRectangleRGBA;
 		renderRect(renderer, bounds.x, bounds.y, bounds.x + bounds.w, bounds.y + bounds.h,
-			cornerRadius, backgroundColor.r * 0xFF, backgroundColor.g * 0xFF, backgroundColor.b * 0xFF, backgroundOpacity);
+			cornerRadius, backgroundColor.r * 0xFF, backgroundColor.g * 0xFF, backgroundColor.b * 0xFF, alpha);
 	} else {
-		CST_SetDrawColorRGBA(renderer, r, g, b, backgroundOpacity);
+		CST_SetDrawColorRGBA(renderer, r, g, b, alpha);
 		const auto renderRect = fill ? CST_FillRect : CST_DrawRect;
 		renderRect(renderer, &bounds);
 	}
@@ -260,6 +704,16 @@ void Element::position(int x, int y)
 	this->y = y;
 }
 
+bool Element::isTouchCandidate()
+{
+	// without the index, everything gets every event
+	if (!RootDisplay::indexTouches || !inTouchIndex)
+		return true;
+
+	// elements that are being dragged or highlighted need to hear about the pointer leaving them
+	return dragging || elasticCounter != NO_HIGHLIGHT || touchCandidateSerial == TouchIndex::eventSerial;
+}
+
 bool Element::onTouchDown(InputEvents* event)
 {
 	if (!event->isTouchDown())
@@ -369,6 +823,13 @@ bool Element::onTouchUp(InputEvents* event)
 				this->dragging = false;
 				this->elasticCounter = 0;
 				
+				// an action can change anything onscreen, so don't limit what gets redrawn
+				if (action != NULL || actionWithEvents != NULL)
+				{
+					RootDisplay::addFullDamage();
+					DisplayList::invalidateAll();
+				}
+
 				// dear future reader: if you're getting a UAF here, try using RootDisplay::deferAction() to schedule your action to run outside of the event processing loop
 				if (action != NULL) {
 					this->action();
@@ -397,23 +858,32 @@ bool Element::onTouchUp(InputEvents* event)
 }
 
 void Element::addNode(std::unique_ptr<Element> node)
+{
+	if (adoptNode(std::move(node)))
+		nodesAdded();
+}
+
+bool Element::adoptNode(std::unique_ptr<Element> node)
 {
 	if (!node) {
 		#ifdef DEBUG
 		printf("[Chesto] Warning: Attempted to add null node to %p\n", this);
 		#endif
-		return;
+		return false;
 	}
 	
 	Element* rawPtr = node.get();
 	
-	// check if element already exists
-	for (const auto& existing : elements) {
-		if (existing.get() == rawPtr) {
-			#ifdef DEBUG
-			printf("[Chesto] Warning: Node %p already exists in parent %p\n", rawPtr, this);
-			#endif
-			return;
+	// check if element already exists (only our children can have us as a parent, so usually there's no need to look)
+	if (rawPtr->parent == this) {
+		for (const auto& existing : elements) {
+			if (existing.get() == rawPtr) {
+				#ifdef DEBUG
+				printf("[Chesto] Warning: Node %p already exists in parent %p\n", rawPtr, this);
+				#endif
+				node.release(); // still owned by the existing entry
+				return false;
+			}
 		}
 	}
 	
@@ -421,10 +891,14 @@ void Element::addNode(std::unique_ptr<Element> node)
 	
 	// transfers ownership and sets up safe deleter
 	Element* ptr = node.release();
-	elements.push_back(std::unique_ptr<Element, std::function<void(Element*)>>(
-		ptr,
-		safeElementDeleter
-	));
+	elements.push_back(ElementPtr(ptr));
+	return true;
+}
+
+void Element::nodesAdded()
+{
+	invalidateDisplayList();
+	ConstraintGraph::structureSerial++;
 }
 
 void Element::addStackMember(Element* element)
@@ -441,12 +915,11 @@ void Element::addStackMember(Element* element)
 	element->parent = this;
 	element->isProtected = true; // Mark as protected
 	
-	// For protected (stack-allocated) elements, use the shared safe deleter
-	// the deleter checks isProtected flag and skips deletion
-	elements.push_back(std::unique_ptr<Element, std::function<void(Element*)>>(
-		element,
-		safeElementDeleter
-	));
+	// For protected (stack-allocated) elements, the shared deleter
+	// checks isProtected flag and skips deletion
+	elements.push_back(ElementPtr(element));
+	invalidateDisplayList();
+	ConstraintGraph::structureSerial++;
 }
 
 
@@ -455,18 +928,24 @@ void Element::remove(Element *element)
 	// single element remove
 
 	auto position = std::find_if(elements.begin(), elements.end(),
-		[element](const std::unique_ptr<Element, std::function<void(Element*)>>& e) { 
+		[element](const ElementPtr& e) { 
 			return e.get() == element; 
 		});
 	if (position != elements.end())
+	{
 		elements.erase(position);
+		invalidateDisplayList();
+		ConstraintGraph::structureSerial++;
+	}
 }
 
 void Element::removeAll()
 {
 	elements.clear();
 	constraints.clear();
-	animations.clear();
+	AnimationTimeline::cancelAll(this);
+	invalidateDisplayList();
+	ConstraintGraph::structureSerial++;
 }
 
 Element* Element::setPosition(int x, int y)
@@ -494,12 +973,14 @@ CST_Renderer* Element::getRenderer() {
 Element* Element::constrain(int flags, int padding)
 {
 	constraints.push_back(std::make_unique<Constraint>(flags, padding));
+	ConstraintGraph::structureSerial++;
 	return this;
 }
 
 Element* Element::constrainToTarget(Element* target, int flags, int padding)
 {
 	constraints.push_back(std::make_unique<Constraint>(flags, padding, std::vector<Element*>{target}));
+	ConstraintGraph::structureSerial++;
 	return this;
 }
 
@@ -509,10 +990,13 @@ Element* Element::animate(
 	std::function<void(float)> onStep,
 	std::function<void()> onFinish
 ) {
-	animations.push_back(std::make_unique<Animation>(
-		CST_GetTicks(),	duration, onStep, onFinish)
-	);
+	AnimationTimeline::animate(this, duration, onStep, onFinish);
+	return this;
+}
 
+Element* Element::tween(int property, float to, int duration, int easing, std::function<void()> onFinish)
+{
+	AnimationTimeline::tween(this, property, to, duration, easing, onFinish);
 	return this;
 }
 
@@ -521,7 +1005,7 @@ Element* Element::moveToFront() {
 	if (parent != NULL) {
 		// lookup this element in parent's vector
 		auto position = std::find_if(parent->elements.begin(), parent->elements.end(),
-			[this](const std::unique_ptr<Element, std::function<void(Element*)>>& e) { 
+			[this](const ElementPtr& e) { 
 				return e.get() == this; 
 			});
 		
@@ -546,7 +1030,7 @@ void Element::screenshot(std::string path) {
 	CST_Texture* target = SDL_CreateTexture(getRenderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
 
 	// set the target texture
-	SDL_SetRenderTarget(getRenderer(), target);
+	CST_SetRenderTarget(getRenderer(), target);
 
     // draw a white background first
     SDL_SetRenderDrawColor(getRenderer(), 255, 255, 255, 255);
@@ -556,7 +1040,7 @@ void Element::screenshot(std::string path) {
     render(parent);
 
 	// reset the target texture
-	SDL_SetRenderTarget(getRenderer(), NULL);
+	CST_SetRenderTarget(getRenderer(), NULL);
 
 	// save the surface to the path
 	CST_SavePNG(target, path.c_str());
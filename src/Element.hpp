@@ -4,8 +4,10 @@
 #include "colorspaces.hpp"
 #include "DrawUtils.hpp"
 #include "Animation.hpp"
+#include "ElementArena.hpp"
 
 #include <functional>
+#include <iterator>
 #include <vector>
 #include <string>
 #include <memory>
@@ -24,6 +26,18 @@
 namespace Chesto {
 
 class Constraint;
+class DisplayList;
+class Element;
+
+/// frees a child element, unless it's protected (a stack member), or through its arena if it came from one.
+/// being stateless, it keeps an ElementPtr the size of a plain pointer
+struct ElementDeleter
+{
+	void operator()(Element* element) const;
+};
+
+/// an owned child element
+typedef std::unique_ptr<Element, ElementDeleter> ElementPtr;
 
 class Element
 {
@@ -43,9 +57,9 @@ public:
 	bool onTouchUp(InputEvents* event);
 
 	// hide the element
-	void hide() { this->hidden = true; }
+	void hide();
 	// unhide the element
-	void unhide() { this->hidden = false; }
+	void unhide();
 
 	// render the element's background
 	void renderBackground(bool fill = true);
@@ -56,21 +70,38 @@ public:
 	std::function<void(InputEvents* event)> actionWithEvents = NULL;
 
 	/// visible GUI child elements of this element
-	std::vector<std::unique_ptr<Element, std::function<void(Element*)>>> elements;
+	std::vector<ElementPtr> elements;
 
 	// add already-built node to tree and transfer ownership to parent
 	void addNode(std::unique_ptr<Element> node);
+
+	// add a range of already-built nodes at once, which only updates the tree once at the end
+	template<typename Range>
+	void addNodes(Range&& nodes) {
+		elements.reserve(elements.size() + std::distance(std::begin(nodes), std::end(nodes)));
+		bool added = false;
+		for (auto& node : nodes)
+			added |= adoptNode(std::move(node));
+		if (added)
+			nodesAdded();
+	}
 	
 	// remove specific child by pointer
-	void remove(Element* element);
+	virtual void remove(Element* element);
 	
 	// clear all children, constraints, and animations
-	void removeAll();
+	virtual void removeAll();
 
 protected:
 	// Internal helper for stack-allocated members
 	void addStackMember(Element* element);
 
+	// take ownership of a node without updating anything else, returns false if it wasn't added
+	bool adoptNode(std::unique_ptr<Element> node);
+
+	// update the tree after nodes were adopted
+	void nodesAdded();
+
 public:
 
 	/// position the element
@@ -78,6 +109,30 @@ public:
 
 	// recalculate xAbs and yAbs based on the given parent
 	void recalcPosition(Element* parent);
+
+	/// make the next recalcPosition run again, even if none of its inputs seem to have changed
+	void invalidateLayout();
+
+	// what our position was last calculated from (for RootDisplay::cacheLayout)
+	struct LayoutInputs
+	{
+		Element* parent;
+		int parentSerial, targetSerials, generation;
+		int x, y, width, height;
+		float scale, globalScale;
+		double angle;
+		bool isAbsolute, touchable;
+		size_t constraintCount;
+	};
+
+	/// gather the current values of everything our position depends on
+	LayoutInputs getLayoutInputs(Element* parent);
+
+	LayoutInputs layoutInputs = {};
+	bool layoutValid = false;
+
+	// increases whenever our calculated position or size changes, so that anything positioned from us updates
+	int layoutSerial = 0;
 	
 	// the effective scale for this element after global scaling
 	float getEffectiveScale() const;
@@ -94,6 +149,9 @@ public:
 	/// whether or not this element needs the screen redrawn next time it's processed
 	bool needsRedraw = false;
 
+	/// whether needsRedraw was set by an animation stepping (for RootDisplay::traceRedraws)
+	bool tweened = false;
+
 	/// whether this element needs a redraw for the next X redraws (decreases each time) (0 is no redraws)
 	int futureRedrawCounter = 0;
 
@@ -121,6 +179,91 @@ public:
 	// bounds on screen of this element
 	CST_Rect getBounds();
 
+	// bounds on screen that this element may draw to (including highlights)
+	CST_Rect getDamageBounds();
+
+	/// report this element's onscreen area as needing a redraw (for partial redraws)
+	void markDamaged();
+
+	/// whether this element overlaps the region of the screen currently being redrawn
+	bool isInDamage();
+
+	// the damage bounds from the last position calculation, to detect movement
+	CST_Rect lastDamageBounds = {0, 0, 0, 0};
+
+	/// render a child of this element, or append its display list if one is being recorded
+	void renderChild(Element* child);
+
+	/// get this element's recorded draw commands, re-recording them first if they're out of date
+	DisplayList* compileDisplayList(Element* parent);
+
+	/// mark this element's (and its parents') recorded draw commands as out of date (for retained rendering)
+	void invalidateDisplayList();
+
+	/// like setting needsRedraw, but also works for elements that aren't being processed (like ones
+	/// on a screen under an AlertDialog), by marking any layer or display list they're drawn from as out of date
+	void requestRedraw();
+
+	// the draw commands from the last time this element was recorded
+	std::unique_ptr<DisplayList> displayList;
+
+	// whether displayList needs to be recorded again before it can be used
+	bool displayListDirty = true;
+
+	// the onscreen position and global generation as of the last recording
+	int recordedX = 0, recordedY = 0;
+	int recordedGeneration = -1;
+
+	/// if set, this element and its children are rendered once into a screen-sized texture, which is
+	/// drawn in their place until something inside changes (see invalidateDisplayList)
+	bool cacheAsLayer = false;
+
+	/// draw this element from its cached layer, re-rendering the layer first if needed. returns false
+	/// if layers aren't supported, in which case the element should be rendered normally
+	bool renderCachedLayer(Element* parent);
+
+	/// free the cached layer texture (it will be recreated if it's needed again)
+	void releaseLayer();
+
+	// the cached layer, and the state it was rendered with
+	CST_Texture* layerTexture = NULL;
+	bool layerDirty = true;
+	int layerX = 0, layerY = 0;
+	int layerWidth = 0, layerHeight = 0;
+	int layerGeneration = -1;
+
+	/// recompute subtreeExtent from our bounds and our visible children's extents (for RootDisplay::cullSubtrees)
+	void updateSubtreeExtent();
+
+	/// mark our (and our parents') subtree extents as out of date, so they can't be culled until they're rendered again
+	void invalidateSubtreeExtent();
+
+	/// whether this element and all of its children are entirely offscreen, or outside of the region being redrawn
+	bool isSubtreeCulled();
+
+	// the area this element and its visible children may draw to, relative to xAbs/yAbs
+	CST_Rect subtreeExtent = {0, 0, 0, 0};
+	bool subtreeExtentValid = false;
+
+	// our damage bounds relative to our parent, to detect moving within a subtree that's being skipped
+	CST_Rect relativeBounds = {0, 0, 0, 0};
+
+	/// whether this element needs to handle the current pointer event (for RootDisplay::indexTouches)
+	bool isTouchCandidate();
+
+	// the range of TouchIndex cells this element is in (x/y are the first cell, w/h the last)
+	CST_Rect touchCells = {0, 0, 0, 0};
+	bool inTouchIndex = false;
+
+	// the TouchIndex event serial of the last pointer event this element was under (or moved during)
+	int touchCandidateSerial = 0;
+
+	// the FocusManager route serial of the last key event this element was on the path of
+	int focusRouteSerial = 0;
+
+	// whether this element is a global key listener in the FocusManager
+	bool isFocusListener = false;
+
 	// whether this element is protected from automatic deletion logic TODO: do we sitl lneed this?
 	bool isProtected = false;
 
@@ -143,6 +286,9 @@ public:
 	/// rotation angle in degrees
 	double angle = 0;
 
+	/// how opaque textures and backgrounds are drawn, from 0 to 0xff (doesn't affect children)
+	int opacity = 0xff;
+
 	// corner radius (when non-zero, backgrounds, textures, and rectangles are rounded)
 	int cornerRadius = 0;
 
@@ -161,25 +307,44 @@ public:
 	// Returns raw pointer for convenience
 	template<typename T, typename... Args>
 	T* createNode(Args&&... args) {
-		auto ptr = std::make_unique<T>(std::forward<Args>(args)...);
-		T* rawPtr = ptr.get();
-		addNode(std::move(ptr));
+		T* rawPtr = newNode<T>(std::forward<Args>(args)...);
+		addNode(std::unique_ptr<Element>(rawPtr));
 		return rawPtr;
 	}
 
+	// construct a node to be added to this element, from our screen's arena if it has one
+	template<typename T, typename... Args>
+	T* newNode(Args&&... args) {
+		ElementArena* nodeArena = getArena();
+		if (nodeArena)
+			return nodeArena->create<T>(std::forward<Args>(args)...);
+		return new T(std::forward<Args>(args)...);
+	}
+
+	/// the arena that new children should be allocated from, or NULL for the heap (see Screen::useArena)
+	virtual ElementArena* getArena();
+
+	// the arena this element was allocated from, if any (it's freed through the arena instead of delete)
+	ElementArena* arena = NULL;
+
 	// constraints that can be added and used by positioning functions
 	std::vector<std::unique_ptr<Constraint>> constraints;
 	Element* constrain(int flags, int padding = 0);
 	Element* constrainToTarget(Element* target, int flags, int padding = 0);
 
-	// animations that can be added and will tween over time (and remove when finished)
-	std::vector<std::unique_ptr<Animation>> animations;
+	// animations run on the AnimationTimeline, and are cancelled if the element is removed
 	Element* animate(
 		int durationIn,
 		std::function<void(float)> onStep,
 		std::function<void()> onFinish
 	);
 
+	/// smoothly move one of our properties (TWEEN_X, TWEEN_Y, TWEEN_SCALE, TWEEN_OPACITY, or TWEEN_ANGLE) to a new value
+	Element* tween(int property, float to, int duration, int easing = EASE_OUT_QUAD, std::function<void()> onFinish = NULL);
+
+	// how many tweens on the timeline are for this element
+	int activeTweens = 0;
+
 	Element* moveToFront();
 	Element* setTouchable(bool touchable);
 
@@ -0,0 +1,104 @@
+#include "ElementArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+namespace Chesto {
+
+ElementArena::~ElementArena()
+{
+	// elements still alive would be left pointing at freed memory
+#ifdef DEBUG
+	if (live > 0)
+		printf("[Chesto] Warning: ElementArena %p destroyed with %d elements alive\n", this, live);
+#endif
+}
+
+void* ElementArena::allocate(size_t size, size_t align)
+{
+	size_t sizeClass = (size + ARENA_SIZE_CLASS - 1) / ARENA_SIZE_CLASS * ARENA_SIZE_CLASS;
+	align = std::max(align, alignof(size_t));
+
+	// reuse the memory of a destroyed element of the same size, if there's one
+	auto found = freeBlocks.find(sizeClass);
+	if (found != freeBlocks.end() && !found->second.empty())
+	{
+		void* memory = found->second.back();
+		if ((uintptr_t)memory % align == 0)
+		{
+			found->second.pop_back();
+			return memory;
+		}
+	}
+
+	while (true)
+	{
+		if (currentChunk < chunks.size())
+		{
+			// each allocation is preceded by its size class, so it can go on the right free list later
+			Chunk& chunk = chunks[currentChunk];
+			size_t start = (offset + sizeof(size_t) + align - 1) & ~(align - 1);
+			if (start + sizeClass <= chunk.size)
+			{
+				offset = start + sizeClass;
+				void* memory = chunk.memory.get() + start;
+				sizeClassOf(memory) = sizeClass;
+				return memory;
+			}
+
+			// move on to the next block (which may have been kept from before a reset)
+			currentChunk++;
+			offset = 0;
+			continue;
+		}
+
+		// oversized elements get a block of their own
+		size_t chunkSize = std::max((size_t)ARENA_CHUNK_SIZE, sizeClass + sizeof(size_t) + align);
+		chunks.push_back({ std::unique_ptr<char[]>(new char[chunkSize]), chunkSize });
+	}
+}
+
+void ElementArena::release(void* memory)
+{
+	if (--live == 0)
+	{
+		if (!owned)
+		{
+			delete this;
+			return;
+		}
+
+		reset();
+		return;
+	}
+
+	freeBlocks[sizeClassOf(memory)].push_back(memory);
+}
+
+void ElementArena::destroyWhenEmpty()
+{
+	owned = false;
+	if (live == 0)
+		delete this;
+}
+
+void ElementArena::reset()
+{
+	currentChunk = 0;
+	offset = 0;
+
+	// everything is free again, so the lists would only point into memory that's handed out from the start
+	for (auto& blocks : freeBlocks)
+		blocks.second.clear();
+}
+
+size_t ElementArena::capacity() const
+{
+	size_t total = 0;
+	for (auto& chunk : chunks)
+		total += chunk.size;
+	return total;
+}
+
+} // namespace Chesto
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Chesto {
+
+/// size of each block of memory the arena carves elements out of
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+/// element sizes are rounded up to a multiple of this, so similar elements can share freed memory
+#define ARENA_SIZE_CLASS 16
+
+/**
+ * An ElementArena hands out memory for a Screen's elements from a few large blocks, instead of a heap
+ * allocation per element (see Screen::useArena). When an element is destroyed, its memory goes on a free
+ * list for its size, and is reused by the next element of that size. When the last one is gone, the arena
+ * starts over at the beginning of its first block. The blocks are kept, so rebuilding a screen (or just
+ * part of it) reuses the same memory every time.
+ *
+ * Each live element holds a reference to the arena, as does the Screen that owns it, so elements moved
+ * out of the screen keep it alive until they're gone too.
+ */
+class ElementArena
+{
+public:
+	ElementArena() = default;
+	~ElementArena();
+
+	ElementArena(const ElementArena&) = delete;
+	ElementArena& operator=(const ElementArena&) = delete;
+
+	/// construct an element in the arena. It has to be freed by the element deleter, which
+	/// calls its destructor and then release()
+	template<typename T, typename... Args>
+	T* create(Args&&... args) {
+		void* memory = allocate(sizeof(T), alignof(T));
+		T* element = new (memory) T(std::forward<Args>(args)...);
+		element->arena = this;
+		live++;
+		return element;
+	}
+
+	/// an element from this arena was destroyed, given the start of its memory (see ElementDeleter)
+	void release(void* memory);
+
+	/// the owner is done with the arena, which deletes itself once no elements from it are alive
+	void destroyWhenEmpty();
+
+	/// how many elements from this arena are still alive
+	int liveCount() const { return live; }
+
+	/// total bytes held in blocks
+	size_t capacity() const;
+
+private:
+	void* allocate(size_t size, size_t align);
+
+	/// start allocating from the beginning again (only when nothing is alive)
+	void reset();
+
+	/// the size class an allocation was made with, stored just before it
+	static size_t& sizeClassOf(void* memory) { return *((size_t*)memory - 1); }
+
+	struct Chunk
+	{
+		std::unique_ptr<char[]> memory;
+		size_t size;
+	};
+
+	std::vector<Chunk> chunks;
+	size_t currentChunk = 0;
+	size_t offset = 0;
+	int live = 0;
+	bool owned = true;
+
+	// memory from destroyed elements, by size class
+	std::unordered_map<size_t, std::vector<void*>> freeBlocks;
+};
+
+} // namespace Chesto
@@ -0,0 +1,91 @@
+#include "FocusManager.hpp"
+#include "Element.hpp"
+
+#include <algorithm>
+
+namespace Chesto {
+
+bool FocusManager::routing = false;
+int FocusManager::routeSerial = 0;
+Element* FocusManager::focused = NULL;
+std::vector<Element*> FocusManager::listeners;
+
+void FocusManager::setFocus(Element* element)
+{
+	focused = element;
+}
+
+Element* FocusManager::getFocus()
+{
+	return focused;
+}
+
+void FocusManager::addListener(Element* element)
+{
+	if (!element || element->isFocusListener)
+		return;
+
+	listeners.push_back(element);
+	element->isFocusListener = true;
+}
+
+void FocusManager::removeListener(Element* element)
+{
+	if (!element || !element->isFocusListener)
+		return;
+
+	listeners.erase(std::remove(listeners.begin(), listeners.end(), element), listeners.end());
+	element->isFocusListener = false;
+}
+
+void FocusManager::forget(Element* element)
+{
+	if (focused == element)
+		focused = NULL;
+
+	removeListener(element);
+}
+
+bool FocusManager::beginEvent(Element* root, InputEvents* event)
+{
+	// touch and other events still go everywhere
+	if (!event->isKeyDown() && !event->isKeyUp())
+		return false;
+
+	routeSerial++;
+	root->focusRouteSerial = routeSerial;
+
+	if (focused)
+		markPath(focused, root);
+
+	for (Element* listener : listeners)
+		markPath(listener, root);
+
+	routing = true;
+	return true;
+}
+
+void FocusManager::endEvent()
+{
+	routing = false;
+}
+
+void FocusManager::markPath(Element* element, Element* root)
+{
+	// first make sure the path actually leads to the root being processed (and not a screen underneath it)
+	Element* cur = element;
+	while (cur && cur != root)
+	{
+		if (cur->hidden)
+			return;
+		cur = cur->parent;
+	}
+
+	if (cur != root)
+		return;
+
+	for (cur = element; cur && cur != root; cur = cur->parent)
+		cur->focusRouteSerial = routeSerial;
+}
+
+} // namespace Chesto
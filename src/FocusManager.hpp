@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+namespace Chesto {
+
+class Element;
+class InputEvents;
+
+/**
+ * The FocusManager routes key and gamepad button events (when RootDisplay::focusDispatch is set).
+ * Instead of every element in the tree processing them, they only go down the path from the root
+ * to the focused element, and to any global listeners (like Buttons with a physical button shortcut).
+ * Every element along those paths still gets its process() called as usual, the rest are skipped.
+ * Elements with a d-pad cursor (Grid, ListElement) listen for keys, and focus whatever they highlight.
+ */
+class FocusManager
+{
+public:
+	/// set the element that key events should be routed to (or NULL for none)
+	static void setFocus(Element* element);
+	static Element* getFocus();
+
+	/// always route key events to this element, as long as it's visible in the current screen
+	static void addListener(Element* element);
+	static void removeListener(Element* element);
+
+	/// stop referring to an element that's being destroyed
+	static void forget(Element* element);
+
+	/// mark the paths to route the given event along, starting from the given root. returns false if it shouldn't be routed
+	static bool beginEvent(Element* root, InputEvents* event);
+
+	/// stop routing, after the event has been processed
+	static void endEvent();
+
+	/// whether key events are currently being routed (so elements off the path should be skipped)
+	static bool routing;
+
+	/// elements on the path for the current event have this serial in focusRouteSerial
+	static int routeSerial;
+
+private:
+	/// mark the element and all of its parents, if they lead back to the root and none are hidden
+	static void markPath(Element* element, Element* root);
+
+	static Element* focused;
+	static std::vector<Element*> listeners;
+};
+
+} // namespace Chesto
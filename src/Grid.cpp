@@ -1,5 +1,13 @@
 #include "Grid.hpp"
+#include "FocusManager.hpp"
 #include "InputEvents.hpp"
+#include "ListElement.hpp"
+#include "RootDisplay.hpp"
+
+#include <algorithm>
+
+// how close the cursor can get to the top or bottom of the screen before the list scrolls
+#define CURSOR_SCROLL_MARGIN 50
 
 namespace Chesto {
 
@@ -19,10 +27,19 @@ Grid::Grid(int columns, int width, int cellPadding, int rowPadding)
 {
 	this->width = width;
 	this->height = 0; // calculated on refresh()
+
+	// the d-pad moves our cursor, even before anything in here is highlighted
+	FocusManager::addListener(this);
 }
 
 void Grid::refresh()
 {
+	// virtualized cells are positioned as they're bound
+	if (dataSource) {
+		reloadData();
+		return;
+	}
+
 	if (elements.empty()) {
 		this->height = 0;
 		return;
@@ -74,35 +91,286 @@ bool Grid::process(InputEvents* event)
 	// This method lets the children elements handle their
 	// touch events, but manages grid-like cursor navigation	
 	bool ret = false;
+
+	if (hidden) return ret;
+
+	// bring in any cells that scrolled onscreen, so they get this event too
+	if (dataSource)
+	{
+		if (parent)
+			recalcPosition(parent);
+		updateCells();
+	}
 	
 	// normal event handling
 	ret |= Element::process(event);
-	
-	if (elements.empty()) {
+
+	// touching anywhere goes back to touch mode, and drops the cursor
+	if (event->isTouch())
+	{
+		if (!touchMode)
+		{
+			touchMode = true;
+			setHighlighted(-1);
+			ret = true;
+		}
 		return ret;
 	}
-	
-	if (touchMode) {
+
+	int total = count();
+	if (total == 0 || !event->isKeyDown()) {
 		return ret;
 	}
-	
-	// cursor logic from HBAS's AppList
-	// int origHighlighted = highlighted;
-	
-	// start highlight if none
-	if (highlighted < 0 && !elements.empty()) {
-		highlighted = 0;
+
+	if (event->held(A_BUTTON) && !touchMode) {
+		Element* cell = cellFor(highlighted);
+		if (cell && cell->action) {
+			cell->action();
+			return true;
+		}
 	}
-	
-	// ensure highlighted is in bounds
-	if (highlighted >= (int)elements.size()) {
-		highlighted = elements.size() - 1;
+
+	if (!event->held(UP_BUTTON | DOWN_BUTTON | LEFT_BUTTON | RIGHT_BUTTON)) {
+		return ret;
 	}
 
-	// TODO: fiinsh grid navigation logic
-	ret = true;
-	
-	return ret;
+	// the first direction pressed just shows the cursor where it was
+	int next = std::max(0, std::min(highlighted, total - 1));
+	if (!touchMode)
+	{
+		// cursor logic from HBAS's AppList, moving by index
+		int col = next % columns;
+		if (event->held(LEFT_BUTTON) && col > 0)
+			next--;
+		else if (event->held(RIGHT_BUTTON) && col < columns - 1 && next + 1 < total)
+			next++;
+		else if (event->held(UP_BUTTON) && next - columns >= 0)
+			next -= columns;
+		else if (event->held(DOWN_BUTTON) && next + columns < total)
+			next += columns;
+		else if (event->held(DOWN_BUTTON) && next / columns < (total - 1) / columns)
+			next = total - 1; // the row below is shorter
+	}
+	touchMode = false;
+
+	if (next == highlighted && cellFor(next) && cellFor(next)->elasticCounter == THICK_HIGHLIGHT) {
+		return ret;
+	}
+
+	setHighlighted(next);
+
+	// scroll a parent ListElement just far enough to keep the cursor onscreen (like HBAS's AppList)
+	ListElement* list = NULL;
+	for (Element* cur = parent; cur && !list; cur = cur->parent)
+		list = dynamic_cast<ListElement*>(cur);
+
+	if (list)
+	{
+		int stride = (dataSource ? cellHeight : elements[next]->height) + rowPadding;
+		int cellY = dataSource ? this->yAbs + (next / columns) * stride : elements[next]->yAbs;
+
+		int offset = 0;
+		if (cellY < CURSOR_SCROLL_MARGIN)
+			offset = CURSOR_SCROLL_MARGIN - cellY;
+		else if (cellY + stride > SCREEN_HEIGHT - CURSOR_SCROLL_MARGIN)
+			offset = (SCREEN_HEIGHT - CURSOR_SCROLL_MARGIN) - (cellY + stride);
+
+		if (offset != 0)
+		{
+			// stop any fling, so it doesn't carry the cursor back offscreen
+			list->elasticCounter = 0;
+			list->y += offset;
+			list->clampScroll();
+		}
+	}
+
+	return true;
+}
+
+void Grid::render(Element* parent)
+{
+	if (hidden) return;
+
+	if (dataSource)
+	{
+		recalcPosition(parent);
+		updateCells();
+	}
+
+	Element::render(parent);
+}
+
+int Grid::count()
+{
+	return dataSource ? itemCount : (int)elements.size();
+}
+
+Element* Grid::cellFor(int index)
+{
+	if (index < 0)
+		return NULL;
+
+	if (!dataSource)
+		return index < (int)elements.size() ? elements[index].get() : NULL;
+
+	if (index < firstCell || index >= firstCell + (int)activeCells.size())
+		return NULL;
+
+	return activeCells[index - firstCell];
+}
+
+void Grid::setHighlighted(int index)
+{
+	Element* cell = cellFor(highlighted);
+	if (cell)
+		cell->elasticCounter = NO_HIGHLIGHT;
+
+	// the highlighted cell gets key events too, like it would without focus dispatch
+	if (cell && FocusManager::getFocus() == cell)
+		FocusManager::setFocus(NULL);
+
+	highlighted = index;
+
+	cell = cellFor(highlighted);
+	if (cell)
+	{
+		cell->elasticCounter = THICK_HIGHLIGHT;
+		FocusManager::setFocus(cell);
+	}
+}
+
+void Grid::remove(Element* element)
+{
+	freeCells.erase(std::remove(freeCells.begin(), freeCells.end(), element), freeCells.end());
+
+	// the cells onscreen are matched to items by their position in activeCells, so recycle them all
+	// and let the next update bind them again
+	if (std::find(activeCells.begin(), activeCells.end(), element) != activeCells.end())
+	{
+		for (Element* cell : activeCells)
+		{
+			if (cell == element)
+				continue;
+			cell->hide();
+			freeCells.push_back(cell);
+		}
+		activeCells.clear();
+	}
+
+	Element::remove(element);
+}
+
+void Grid::removeAll()
+{
+	activeCells.clear();
+	freeCells.clear();
+	firstCell = 0;
+
+	Element::removeAll();
+}
+
+void Grid::setDataSource(GridDataSource* dataSource, int cellHeight)
+{
+	// drop any cells from a previous data source
+	for (Element* cell : activeCells)
+		Element::remove(cell);
+	for (Element* cell : freeCells)
+		Element::remove(cell);
+	activeCells.clear();
+	freeCells.clear();
+	firstCell = 0;
+
+	this->dataSource = dataSource;
+	this->cellHeight = cellHeight;
+
+	reloadData();
+}
+
+void Grid::reloadData()
+{
+	if (!dataSource)
+		return;
+
+	itemCount = dataSource->getItemCount();
+
+	int rows = (itemCount + columns - 1) / columns;
+	this->height = rows > 0 ? rows * (cellHeight + rowPadding) - rowPadding : 0;
+
+	if (highlighted >= itemCount)
+		highlighted = itemCount - 1;
+
+	// the items may be different now, so every cell needs to be bound again
+	for (Element* cell : activeCells)
+	{
+		cell->hide();
+		freeCells.push_back(cell);
+	}
+	activeCells.clear();
+
+	updateCells();
+}
+
+void Grid::updateCells()
+{
+	if (!dataSource || columns <= 0 || cellHeight <= 0)
+		return;
+
+	// the rows onscreen, only depends on where we are and not how many items there are
+	int stride = cellHeight + rowPadding;
+	int firstRow = std::max(0, -this->yAbs / stride - overscan);
+	int lastRow = (SCREEN_HEIGHT - this->yAbs) / stride + 1 + overscan;
+
+	int first = std::min(firstRow * columns, itemCount);
+	int last = std::max(first, std::min(lastRow * columns, itemCount));
+
+	if (first == firstCell && last - first == (int)activeCells.size())
+		return;
+
+	// keep cells that are still onscreen, and recycle the rest
+	std::vector<Element*> cells(last - first, NULL);
+	for (size_t i = 0; i < activeCells.size(); i++)
+	{
+		int index = firstCell + i;
+		if (index >= first && index < last)
+			cells[index - first] = activeCells[i];
+		else
+		{
+			activeCells[i]->hide();
+			freeCells.push_back(activeCells[i]);
+		}
+	}
+
+	int cellWidth = (this->width - (cellPadding * (columns - 1))) / columns;
+
+	for (int i = 0; i < last - first; i++)
+	{
+		if (cells[i])
+			continue;
+
+		Element* cell;
+		if (!freeCells.empty())
+		{
+			cell = freeCells.back();
+			freeCells.pop_back();
+			cell->unhide();
+		}
+		else
+		{
+			auto created = dataSource->createCell();
+			cell = created.get();
+			addNode(std::move(created));
+		}
+
+		int index = first + i;
+		cell->position((index % columns) * (cellWidth + cellPadding), (index / columns) * stride);
+		dataSource->bindCell(cell, index);
+		cell->elasticCounter = (index == highlighted && !touchMode) ? THICK_HIGHLIGHT : NO_HIGHLIGHT;
+		cell->needsRedraw = true;
+		cells[i] = cell;
+	}
+
+	activeCells.swap(cells);
+	firstCell = first;
 }
 
 } // namespace Chesto
@@ -5,6 +5,22 @@
 
 namespace Chesto {
 
+/// Supplies the cells of a virtualized Grid (see Grid::setDataSource)
+class GridDataSource
+{
+public:
+	virtual ~GridDataSource() = default;
+
+	/// the total number of items in the grid
+	virtual int getItemCount() = 0;
+
+	/// make a new cell, which will be reused for different items as the grid scrolls
+	virtual std::unique_ptr<Element> createCell() = 0;
+
+	/// fill in a cell for the item at the given index
+	virtual void bindCell(Element* cell, int index) = 0;
+};
+
 class Grid : public Element
 {
 public:
@@ -12,7 +28,32 @@ public:
 	
 	/// Recalculate positions for all child elements
 	void refresh();
+
+	/// add several children at once, and position them all with one refresh
+	template<typename Range>
+	void addAll(Range&& elems) {
+		addNodes(elems);
+		refresh();
+	}
 	bool process(InputEvents* event) override;
+	void render(Element* parent) override;
+
+	/// virtualize the grid: only the cells onscreen (plus overscan rows) exist, and are rebound from the
+	/// data source as it scrolls. Every cell is cellHeight tall. The data source isn't owned by the grid
+	void setDataSource(GridDataSource* dataSource, int cellHeight);
+
+	/// get the item count from the data source again, and rebind every cell
+	void reloadData();
+
+	/// the cell element for an item, or NULL if it isn't onscreen in a virtualized grid
+	Element* cellFor(int index);
+
+	/// also stop tracking the removed cells, if virtualized
+	void remove(Element* element) override;
+	void removeAll() override;
+
+	/// how many extra rows of cells to keep above and below the screen when virtualized
+	int overscan = 1;
 	
 	int columns;
 	int width;
@@ -22,6 +63,27 @@ public:
 	/// Cursor state
 	int highlighted = -1;  // Ccrrently highlighted element index (-1 = none)
 	bool touchMode = true;  // whether we're in touch or cursor mode
+
+private:
+	/// the number of items, from the data source or children
+	int count();
+
+	/// move the cursor highlight to another index
+	void setHighlighted(int index);
+
+	/// make sure the cells onscreen exist and are bound, recycling ones that scrolled off
+	void updateCells();
+
+	GridDataSource* dataSource = NULL;
+	int cellHeight = 0;
+	int itemCount = 0;
+
+	// cells currently bound, activeCells[i] showing item firstCell + i
+	std::vector<Element*> activeCells;
+	int firstCell = 0;
+
+	// hidden cells ready to be bound to another item
+	std::vector<Element*> freeCells;
 };
 
 } // namespace Chesto
@@ -1,5 +1,6 @@
 #include "InputEvents.hpp"
 #include "RootDisplay.hpp"
+#include "InputRecorder.hpp"
 #include <map>
 #include <algorithm>
 #include <limits>
@@ -78,10 +79,25 @@ InputEvents::InputEvents()
 
 bool InputEvents::processSDLEvents()
 {
+	if (InputRecorder::isReplaying())
+	{
+		// real input is ignored while replaying, except for quitting
+		SDL_Event real;
+		bool quit = false;
+		while (!quit && SDL_PollEvent(&real))
+			quit = real.type == SDL_QUIT;
+
+		if (quit)
+			event = real;
+		else if (!InputRecorder::nextEvent(&event))
+			return false;
+	}
 	// get an event from SDL
-	if (!SDL_PollEvent(&event))
+	else if (!SDL_PollEvent(&event))
 		return false;
 
+	InputRecorder::record(event);
+
 	// update our variables
 	this->type = event.type;
 	this->noop = false;
@@ -250,6 +266,17 @@ bool InputEvents::processDirectionalButtons()
 	return false;
 }
 
+// whether any direction is held down (and will need repeat events fired as frames pass)
+bool InputEvents::isHoldingDirection()
+{
+	for (int x = 0; x < 4; x++)
+	{
+		if (held_directions[x])
+			return true;
+	}
+	return false;
+}
+
 int InputEvents::directionForKeycode()
 {
 	// this keycode overlaps with some other constants, so just return asap
@@ -106,6 +106,7 @@ public:
 
 	// additional key processing info
 	bool processDirectionalButtons();
+	bool isHoldingDirection();
 	int directionForKeycode();
 	void toggleHeldButtons();
 
@@ -0,0 +1,419 @@
+#include "InputRecorder.hpp"
+#include "Clock.hpp"
+#include "Scheduler.hpp"
+
+#include <string.h>
+
+namespace Chesto {
+
+FILE* InputRecorder::recordFile = NULL;
+std::vector<uint8_t> InputRecorder::writeBuffer;
+
+std::vector<uint8_t> InputRecorder::replayData;
+size_t InputRecorder::replayPos = 0;
+bool InputRecorder::replaying = false;
+bool InputRecorder::replayFast = false;
+bool InputRecorder::hasPending = false;
+SDL_Event InputRecorder::pending;
+int InputRecorder::pendingTime = 0;
+int InputRecorder::pendingFrame = 0;
+
+int InputRecorder::frame = 0;
+int InputRecorder::recordStartTime = 0;
+int InputRecorder::recordStartFrame = 0;
+int InputRecorder::lastTime = 0;
+int InputRecorder::lastFrame = 0;
+int InputRecorder::replayStartTime = 0;
+int InputRecorder::replayStartFrame = 0;
+
+std::function<void()> InputRecorder::onReplayFinished = NULL;
+
+bool InputRecorder::startRecording(const std::string& path)
+{
+	stopRecording();
+
+	recordFile = fopen(path.c_str(), "wb");
+	if (!recordFile)
+	{
+		printf("[InputRecorder] Couldn't open %s for recording\n", path.c_str());
+		return false;
+	}
+
+	fwrite(INPUT_RECORDING_MAGIC, 1, 4, recordFile);
+	fputc(INPUT_RECORDING_VERSION, recordFile);
+
+	recordStartTime = Clock::now();
+	recordStartFrame = frame;
+	lastTime = 0;
+	lastFrame = 0;
+	return true;
+}
+
+void InputRecorder::stopRecording()
+{
+	if (!recordFile)
+		return;
+
+	if (!writeBuffer.empty())
+		fwrite(writeBuffer.data(), 1, writeBuffer.size(), recordFile);
+	writeBuffer.clear();
+
+	fclose(recordFile);
+	recordFile = NULL;
+}
+
+bool InputRecorder::startReplay(const std::string& path, bool fast)
+{
+	stopReplay();
+
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		printf("[InputRecorder] Couldn't open %s for replaying\n", path.c_str());
+		return false;
+	}
+
+	replayData.clear();
+	uint8_t chunk[4096];
+	size_t count;
+	while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		replayData.insert(replayData.end(), chunk, chunk + count);
+	fclose(file);
+
+	if (replayData.size() < 5 || memcmp(replayData.data(), INPUT_RECORDING_MAGIC, 4) != 0
+		|| replayData[4] != INPUT_RECORDING_VERSION)
+	{
+		printf("[InputRecorder] %s isn't a recording this version can replay\n", path.c_str());
+		replayData.clear();
+		return false;
+	}
+
+	replayPos = 5;
+	replaying = true;
+	replayFast = fast;
+	hasPending = false;
+	pendingTime = 0;
+	pendingFrame = 0;
+	replayStartTime = Clock::now();
+	replayStartFrame = frame;
+
+	// get the loop going, in case it's idle
+	Scheduler::requestFrameIn(0);
+	return true;
+}
+
+void InputRecorder::stopReplay()
+{
+	replaying = false;
+	hasPending = false;
+	replayData.clear();
+	replayData.shrink_to_fit();
+}
+
+bool InputRecorder::isRecording()
+{
+	return recordFile != NULL;
+}
+
+bool InputRecorder::isReplaying()
+{
+	return replaying;
+}
+
+void InputRecorder::beginFrame()
+{
+	frame++;
+
+	// write out the last frame's events, so as little as possible is lost if the app crashes
+	if (recordFile && !writeBuffer.empty())
+	{
+		fwrite(writeBuffer.data(), 1, writeBuffer.size(), recordFile);
+		fflush(recordFile);
+		writeBuffer.clear();
+	}
+}
+
+void InputRecorder::record(const SDL_Event& event)
+{
+	if (!recordFile)
+		return;
+
+	// only the events that InputEvents reacts to (not wakeups, or hotplugging, which would open real devices)
+	switch (event.type)
+	{
+	case SDL_QUIT:
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+	case SDL_JOYBUTTONDOWN:
+	case SDL_JOYBUTTONUP:
+	case SDL_MOUSEMOTION:
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP:
+	case SDL_MOUSEWHEEL:
+	case SDL_FINGERDOWN:
+	case SDL_FINGERUP:
+	case SDL_FINGERMOTION:
+	case SDL_WINDOWEVENT:
+		break;
+	default:
+		return;
+	}
+
+	int time = Clock::now() - recordStartTime;
+	int frameNumber = frame - recordStartFrame;
+	write(time - lastTime);
+	write(frameNumber - lastFrame);
+	write(event.type);
+	lastTime = time;
+	lastFrame = frameNumber;
+
+	switch (event.type)
+	{
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+		write(event.key.repeat);
+		write(event.key.keysym.scancode);
+		writeSigned(event.key.keysym.sym);
+		write(event.key.keysym.mod);
+		break;
+	case SDL_JOYBUTTONDOWN:
+	case SDL_JOYBUTTONUP:
+		writeSigned(event.jbutton.which);
+		write(event.jbutton.button);
+		break;
+	case SDL_MOUSEMOTION:
+		write(event.motion.which);
+		write(event.motion.state);
+		writeSigned(event.motion.x);
+		writeSigned(event.motion.y);
+		writeSigned(event.motion.xrel);
+		writeSigned(event.motion.yrel);
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP:
+		write(event.button.which);
+		write(event.button.button);
+		write(event.button.clicks);
+		writeSigned(event.button.x);
+		writeSigned(event.button.y);
+		break;
+	case SDL_MOUSEWHEEL:
+		write(event.wheel.which);
+		writeSigned(event.wheel.x);
+		writeSigned(event.wheel.y);
+		write(event.wheel.direction);
+		break;
+	case SDL_FINGERDOWN:
+	case SDL_FINGERUP:
+	case SDL_FINGERMOTION:
+		writeSigned(event.tfinger.touchId);
+		writeSigned(event.tfinger.fingerId);
+		writeFloat(event.tfinger.x);
+		writeFloat(event.tfinger.y);
+		writeFloat(event.tfinger.dx);
+		writeFloat(event.tfinger.dy);
+		writeFloat(event.tfinger.pressure);
+		break;
+	case SDL_WINDOWEVENT:
+		write(event.window.event);
+		writeSigned(event.window.data1);
+		writeSigned(event.window.data2);
+		break;
+	}
+}
+
+bool InputRecorder::nextEvent(SDL_Event* event)
+{
+	if (!replaying)
+		return false;
+
+	if (!hasPending && !decodeNext())
+	{
+		stopReplay();
+		if (onReplayFinished)
+			onReplayFinished();
+		return false;
+	}
+
+	if (replayFast)
+	{
+		// events come in the same frames they were recorded in, and frames run back to back
+		if (frame - replayStartFrame < pendingFrame)
+		{
+			Scheduler::requestFrameIn(0);
+			return false;
+		}
+	}
+	else
+	{
+		// wake up the loop exactly when the event is due
+		int elapsed = Clock::now() - replayStartTime;
+		if (elapsed < pendingTime)
+		{
+			Scheduler::requestFrameIn(pendingTime - elapsed);
+			return false;
+		}
+	}
+
+	*event = pending;
+	event->common.timestamp = Clock::now();
+	hasPending = false;
+	return true;
+}
+
+bool InputRecorder::decodeNext()
+{
+	uint64_t timeDelta, frameDelta, type;
+	if (!read(&timeDelta) || !read(&frameDelta) || !read(&type))
+		return false;
+
+	pendingTime += (int)timeDelta;
+	pendingFrame += (int)frameDelta;
+
+	SDL_Event& event = pending;
+	memset(&event, 0, sizeof(event));
+	event.type = (Uint32)type;
+
+	uint64_t value;
+	switch (event.type)
+	{
+	case SDL_QUIT:
+		break;
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+		event.key.state = event.type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+		event.key.repeat = read(&value) ? value : 0;
+		event.key.keysym.scancode = (SDL_Scancode)(read(&value) ? value : 0);
+		event.key.keysym.sym = readSigned();
+		event.key.keysym.mod = read(&value) ? value : 0;
+		break;
+	case SDL_JOYBUTTONDOWN:
+	case SDL_JOYBUTTONUP:
+		event.jbutton.state = event.type == SDL_JOYBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+		event.jbutton.which = readSigned();
+		event.jbutton.button = read(&value) ? value : 0;
+		break;
+	case SDL_MOUSEMOTION:
+		event.motion.which = read(&value) ? value : 0;
+		event.motion.state = read(&value) ? value : 0;
+		event.motion.x = readSigned();
+		event.motion.y = readSigned();
+		event.motion.xrel = readSigned();
+		event.motion.yrel = readSigned();
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP:
+		event.button.state = event.type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+		event.button.which = read(&value) ? value : 0;
+		event.button.button = read(&value) ? value : 0;
+		event.button.clicks = read(&value) ? value : 0;
+		event.button.x = readSigned();
+		event.button.y = readSigned();
+		break;
+	case SDL_MOUSEWHEEL:
+		event.wheel.which = read(&value) ? value : 0;
+		event.wheel.x = readSigned();
+		event.wheel.y = readSigned();
+		event.wheel.direction = read(&value) ? value : 0;
+		break;
+	case SDL_FINGERDOWN:
+	case SDL_FINGERUP:
+	case SDL_FINGERMOTION:
+		event.tfinger.touchId = readSigned();
+		event.tfinger.fingerId = readSigned();
+		event.tfinger.x = readFloat();
+		event.tfinger.y = readFloat();
+		event.tfinger.dx = readFloat();
+		event.tfinger.dy = readFloat();
+		event.tfinger.pressure = readFloat();
+		break;
+	case SDL_WINDOWEVENT:
+		event.window.event = read(&value) ? value : 0;
+		event.window.data1 = readSigned();
+		event.window.data2 = readSigned();
+		break;
+	default:
+		// a type that's never written, so the rest of the stream can't be trusted
+		return false;
+	}
+
+	// a field ran past the end of the file
+	if (replayPos > replayData.size())
+		return false;
+
+	hasPending = true;
+	return true;
+}
+
+void InputRecorder::write(uint64_t value)
+{
+	// 7 bits at a time, with the high bit set on every byte but the last
+	while (value >= 0x80)
+	{
+		writeBuffer.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	writeBuffer.push_back((uint8_t)value);
+}
+
+void InputRecorder::writeSigned(int64_t value)
+{
+	// zigzag, so small negative numbers stay small
+	write(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void InputRecorder::writeFloat(float value)
+{
+	// always little endian, so recordings can move between platforms
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	for (int i = 0; i < 4; i++)
+		writeBuffer.push_back((uint8_t)(bits >> (i * 8)));
+}
+
+bool InputRecorder::read(uint64_t* value)
+{
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (replayPos >= replayData.size())
+		{
+			// mark the stream as truncated
+			replayPos = replayData.size() + 1;
+			return false;
+		}
+
+		uint8_t byte = replayData[replayPos++];
+		*value |= (uint64_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+int64_t InputRecorder::readSigned()
+{
+	uint64_t value;
+	if (!read(&value))
+		return 0;
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+float InputRecorder::readFloat()
+{
+	if (replayPos + 4 > replayData.size())
+	{
+		replayPos = replayData.size() + 1;
+		return 0;
+	}
+
+	uint32_t bits = 0;
+	for (int i = 0; i < 4; i++)
+		bits |= (uint32_t)replayData[replayPos++] << (i * 8);
+
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+} // namespace Chesto
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <functional>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace Chesto {
+
+/// written at the start of every recording, followed by a version byte
+#define INPUT_RECORDING_MAGIC "CSTI"
+#define INPUT_RECORDING_VERSION 1
+
+/**
+ * The InputRecorder captures the SDL events that InputEvents handles, and can feed them back in later,
+ * so that a session (like one where scrolling janked) can be reproduced exactly, under the profiler or
+ * on a headless display. Recordings are a compact binary stream. Each event is stored as variable-length
+ * integers: the ms and frames since the previous event, the SDL event type, and only the fields of that
+ * type that are used (so they don't depend on SDL's struct layouts).
+ *
+ * They can be started with the CHESTO_RECORD_INPUT or CHESTO_REPLAY_INPUT environment variables (with
+ * CHESTO_REPLAY_FAST set for a fast replay), or from code.
+ */
+class InputRecorder
+{
+public:
+	/// start writing every handled event to the given file, returns false if it couldn't be opened
+	static bool startRecording(const std::string& path);
+
+	/// finish writing the recording
+	static void stopRecording();
+
+	/// start feeding the events in the given recording to InputEvents, instead of real input.
+	/// by default they're replayed at their original times. If fast is set, they're replayed in the same
+	/// frames as they were recorded in, with no waiting between frames
+	static bool startReplay(const std::string& path, bool fast = false);
+
+	/// go back to real input
+	static void stopReplay();
+
+	static bool isRecording();
+	static bool isReplaying();
+
+	/// save an event to the recording (called by InputEvents for every event it gets)
+	static void record(const SDL_Event& event);
+
+	/// get the next recorded event if it's due, returns false if there isn't one yet
+	static bool nextEvent(SDL_Event* event);
+
+	/// called at the start of every frame
+	static void beginFrame();
+
+	/// called once a replay has run out of events
+	static std::function<void()> onReplayFinished;
+
+private:
+	// reading and writing variable-length integers (signed ones are zigzag encoded), and floats
+	static void write(uint64_t value);
+	static void writeSigned(int64_t value);
+	static void writeFloat(float value);
+	static bool read(uint64_t* value);
+	static int64_t readSigned();
+	static float readFloat();
+
+	/// decode the next event in the replay into pending, returns false at the end (or if it's corrupt)
+	static bool decodeNext();
+
+	static FILE* recordFile;
+	static std::vector<uint8_t> writeBuffer;
+
+	static std::vector<uint8_t> replayData;
+	static size_t replayPos;
+	static bool replaying;
+	static bool replayFast;
+	static bool hasPending;
+	static SDL_Event pending;
+	static int pendingTime, pendingFrame;
+
+	// frames run so far
+	static int frame;
+
+	// when recording started, and the time and frame of the last recorded event (relative to that)
+	static int recordStartTime, recordStartFrame;
+	static int lastTime, lastFrame;
+
+	// when replaying started (the pending event's time and frame are relative to this)
+	static int replayStartTime, replayStartFrame;
+};
+
+} // namespace Chesto
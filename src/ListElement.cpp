@@ -1,7 +1,17 @@
 #include "ListElement.hpp"
+#include "FocusManager.hpp"
+#include "RootDisplay.hpp"
+
+#include <algorithm>
 
 namespace Chesto {
 
+ListElement::ListElement()
+{
+	// up and down scroll the list (or move its highlight), wherever the focus is inside of it
+	FocusManager::addListener(this);
+}
+
 bool ListElement::process(InputEvents* event)
 {
 	bool ret = false;
@@ -12,11 +22,174 @@ bool ListElement::process(InputEvents* event)
 	// perform inertia scrolling for this element
 	ret |= this->handleInertiaScroll(event);
 
+	// bring in any rows that scrolled into view, so they get this event too
+	updateRows();
+
 	ret |= super::process(event);
 
 	return ret;
 }
 
+void ListElement::render(Element* parent)
+{
+	if (hidden) return;
+
+	updateRows();
+
+	super::render(parent);
+}
+
+void ListElement::setVirtualized(int itemCount, int rowHeight,
+	std::function<std::unique_ptr<Element>()> createRow,
+	std::function<void(Element* row, int index)> bindRow)
+{
+	// drop any rows from a previous call
+	for (Element* row : activeRows)
+		Element::remove(row);
+	for (Element* row : freeRows)
+		Element::remove(row);
+	activeRows.clear();
+	freeRows.clear();
+	firstRow = 0;
+
+	this->virtualized = true;
+	this->rowHeight = rowHeight;
+	this->createRow = createRow;
+	this->bindRow = bindRow;
+
+	setItemCount(itemCount);
+}
+
+void ListElement::setItemCount(int itemCount)
+{
+	this->itemCount = itemCount;
+	this->height = itemCount * rowHeight;
+
+	// the items may have moved to different indices, so start over with the recycled rows
+	for (Element* row : activeRows)
+	{
+		row->hide();
+		freeRows.push_back(row);
+	}
+	activeRows.clear();
+
+	clampScroll();
+	updateRows();
+}
+
+void ListElement::reloadRows()
+{
+	for (size_t i = 0; i < activeRows.size(); i++)
+	{
+		bindRow(activeRows[i], firstRow + i);
+		activeRows[i]->needsRedraw = true;
+	}
+}
+
+void ListElement::remove(Element* element)
+{
+	freeRows.erase(std::remove(freeRows.begin(), freeRows.end(), element), freeRows.end());
+
+	// the rows in view are matched to items by their position in activeRows, so recycle them all
+	// and let the next update bind them again
+	if (std::find(activeRows.begin(), activeRows.end(), element) != activeRows.end())
+	{
+		for (Element* row : activeRows)
+		{
+			if (row == element)
+				continue;
+			row->hide();
+			freeRows.push_back(row);
+		}
+		activeRows.clear();
+	}
+
+	super::remove(element);
+}
+
+void ListElement::removeAll()
+{
+	activeRows.clear();
+	freeRows.clear();
+	firstRow = 0;
+
+	super::removeAll();
+}
+
+void ListElement::clampScroll()
+{
+	if (virtualized)
+	{
+		// don't scroll past the last row
+		int viewport = viewportHeight > 0 ? viewportHeight : SCREEN_HEIGHT;
+		int maxScroll = std::max(0, itemCount * rowHeight - viewport);
+		if (this->y < minYScroll - maxScroll)
+			this->y = minYScroll - maxScroll;
+	}
+
+	if (this->y > minYScroll)
+		this->y = minYScroll;
+}
+
+void ListElement::updateRows()
+{
+	if (!virtualized || rowHeight <= 0)
+		return;
+
+	// the range of items in view, only depends on the scroll position and not the number of items
+	int viewport = viewportHeight > 0 ? viewportHeight : SCREEN_HEIGHT;
+	int scroll = std::max(0, minYScroll - this->y);
+	int first = std::max(0, scroll / rowHeight - overscan);
+	int last = std::min(itemCount, (scroll + viewport) / rowHeight + 1 + overscan);
+	if (last < first)
+		last = first;
+
+	if (first == firstRow && last - first == (int)activeRows.size())
+		return;
+
+	// keep rows that are still in view, and recycle the rest
+	std::vector<Element*> rows(last - first, NULL);
+	for (size_t i = 0; i < activeRows.size(); i++)
+	{
+		int index = firstRow + i;
+		if (index >= first && index < last)
+			rows[index - first] = activeRows[i];
+		else
+		{
+			activeRows[i]->hide();
+			freeRows.push_back(activeRows[i]);
+		}
+	}
+
+	for (int i = 0; i < last - first; i++)
+	{
+		if (rows[i])
+			continue;
+
+		Element* row;
+		if (!freeRows.empty())
+		{
+			row = freeRows.back();
+			freeRows.pop_back();
+			row->unhide();
+		}
+		else
+		{
+			auto created = createRow();
+			row = created.get();
+			addNode(std::move(created));
+		}
+
+		row->position(0, (first + i) * rowHeight);
+		bindRow(row, first + i);
+		row->needsRedraw = true;
+		rows[i] = row;
+	}
+
+	activeRows.swap(rows);
+	firstRow = first;
+}
+
 bool ListElement::processUpDown(InputEvents* event)
 {
 	bool ret = false;
@@ -78,11 +251,9 @@ bool ListElement::handleInertiaScroll(InputEvents* event)
 		// mouse up, no more mouse down (TODO: fire selected event here)
 		elem->dragging = false;
 
-		// if the scroll offset is less than the total number of apps
+		// keep the scroll offset in range
 		// (put on the mouse up to make it "snap" when going out of bounds)
-		// TODO: account for max number of apps too (prevent scrolling down forever)
-		if (elem->y > minYScroll)
-			elem->y = minYScroll;
+		clampScroll();
 
 		ret |= true;
 	}
@@ -99,9 +270,7 @@ bool ListElement::handleInertiaScroll(InputEvents* event)
 		if (abs(elem->elasticCounter) < 10)
 			elem->elasticCounter = 0;
 
-		// TODO: same problem as above todo, also extract into method?
-		if (elem->y > minYScroll)
-			elem->y = minYScroll;
+		clampScroll();
 
 		ret |= true;
 	}
@@ -112,8 +281,7 @@ bool ListElement::handleInertiaScroll(InputEvents* event)
 	{
 		// apply wheel scroll directly to y position, and then reset
 		elem->y += event->wheelScroll * 10;
-		if (elem->y > minYScroll)
-			elem->y = minYScroll;
+		clampScroll();
 		event->wheelScroll *= 0.95;
 
 		if (abs(event->wheelScroll) < 0.1)
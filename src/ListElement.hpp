@@ -8,12 +8,58 @@ namespace Chesto {
 class ListElement : public Element
 {
 public:
+	ListElement();
+
 	int highlighted = -1;
 	int initialTouchDown = -1;
 	int minYScroll = 0;
 	bool process(InputEvents* event);
+	void render(Element* parent) override;
 	bool handleInertiaScroll(InputEvents* event);
 	bool processUpDown(InputEvents* event);
+
+	/// turn this into a virtualized list of itemCount rows, each rowHeight tall. Only the rows in view
+	/// (plus overscan) exist as elements: createRow makes a new one, and bindRow fills it in for an item
+	void setVirtualized(int itemCount, int rowHeight,
+		std::function<std::unique_ptr<Element>()> createRow,
+		std::function<void(Element* row, int index)> bindRow);
+
+	/// change the number of items in a virtualized list (every row in view is bound again)
+	void setItemCount(int itemCount);
+
+	/// bind every row in view again, after the underlying data changed
+	void reloadRows();
+
+	/// keep the scroll position between the first and last rows (only the top is clamped if not virtualized)
+	void clampScroll();
+
+	/// also stop tracking the removed rows, if virtualized
+	void remove(Element* element) override;
+	void removeAll() override;
+
+	/// height of the area the list is seen through, to know which rows are visible (0 for the screen height)
+	int viewportHeight = 0;
+
+	/// how many extra rows to keep above and below the visible ones
+	int overscan = 2;
+
+	bool virtualized = false;
+	int itemCount = 0;
+	int rowHeight = 0;
+
+private:
+	/// make sure the rows in view exist and are bound, recycling ones that scrolled out
+	void updateRows();
+
+	std::function<std::unique_ptr<Element>()> createRow = NULL;
+	std::function<void(Element* row, int index)> bindRow = NULL;
+
+	// rows currently bound, activeRows[i] showing item firstRow + i
+	std::vector<Element*> activeRows;
+	int firstRow = 0;
+
+	// hidden rows ready to be bound to another item
+	std::vector<Element*> freeRows;
 };
 
 } // namespace Chesto
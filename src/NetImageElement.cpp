@@ -78,7 +78,7 @@ void NetImageElement::imgDownloadComplete(DownloadOperation *download)
 
 	if (success)
 	{
-		this->needsRedraw = true;
+		this->requestRedraw();
 		loaded = true;
 
 		delete imgFallback;
@@ -0,0 +1,119 @@
+#include "PerfOverlay.hpp"
+#include "RootDisplay.hpp"
+
+#include <algorithm>
+
+namespace Chesto {
+
+RenderStats PerfOverlay::stats;
+RenderStats PerfOverlay::lastStats;
+float PerfOverlay::frameTimes[PERF_HISTORY] = {};
+int PerfOverlay::frameIndex = 0;
+double PerfOverlay::frameStart = 0;
+double PerfOverlay::lastFrameEnd = 0;
+float PerfOverlay::lastRenderTime = 0;
+
+// frame times at or above this fill the whole height of the graph
+#define GRAPH_MAX_MS 50.0f
+
+// gaps between frames longer than this aren't counted
+#define IDLE_GAP_MS 250
+
+PerfOverlay::PerfOverlay()
+{
+	this->width = PERF_HISTORY * 2;
+	this->height = 150;
+}
+
+PerfOverlay::~PerfOverlay()
+{
+	if (font)
+		FC_FreeFont(font);
+}
+
+void PerfOverlay::beginFrame()
+{
+	stats = RenderStats();
+	frameStart = CST_GetPreciseTicks();
+}
+
+void PerfOverlay::endFrame()
+{
+	lastStats = stats;
+
+	double now = CST_GetPreciseTicks();
+	lastRenderTime = (float)(now - frameStart);
+
+	// long gaps are from the main loop sleeping while idle, not from slow frames
+	if (lastFrameEnd > 0 && now - lastFrameEnd < IDLE_GAP_MS)
+	{
+		frameTimes[frameIndex] = (float)(now - lastFrameEnd);
+		frameIndex = (frameIndex + 1) % PERF_HISTORY;
+	}
+	lastFrameEnd = now;
+}
+
+void PerfOverlay::render(Element* parent)
+{
+	if (hidden) return;
+
+	auto renderer = getRenderer();
+
+	if (!font)
+	{
+		// a font cache only rasterizes each glyph once, unlike a TextElement which would need a new texture every frame
+		font = CST_CreateFont();
+		auto fontPath = RAMFS "./res/fonts/UbuntuMono-Regular.ttf";
+		CST_LoadFont(font, renderer, fontPath, 16, CST_MakeColor(0xff, 0xff, 0xff, 0xff), TTF_STYLE_NORMAL);
+	}
+
+	// pinned to the top right corner
+	this->x = SCREEN_WIDTH - this->width - 10;
+	this->y = 10;
+	this->recalcPosition(parent);
+
+	CST_Rect bg = { xAbs, yAbs, width, height };
+	CST_SetDrawBlend(renderer, true);
+	CST_SetDrawColorRGBA(renderer, 0x00, 0x00, 0x00, 0xbb);
+	CST_FillRect(renderer, &bg);
+
+	// average over the whole history for a steadier fps number
+	float total = 0;
+	int count = 0;
+	for (int i = 0; i < PERF_HISTORY; i++)
+	{
+		if (frameTimes[i] > 0)
+		{
+			total += frameTimes[i];
+			count++;
+		}
+	}
+	float fps = total > 0 ? count * 1000.0f / total : 0;
+
+	// frame time graph, oldest on the left, green if it fits in 60fps and red otherwise
+	int graphBottom = yAbs + 50;
+	for (int i = 0; i < PERF_HISTORY; i++)
+	{
+		float ms = frameTimes[(frameIndex + i) % PERF_HISTORY];
+		int barHeight = (int)(std::min(ms, GRAPH_MAX_MS) / GRAPH_MAX_MS * 45);
+		if (barHeight <= 0)
+			continue;
+
+		if (ms <= 17)
+			CST_SetDrawColorRGBA(renderer, 0x40, 0xd0, 0x60, 0xff);
+		else
+			CST_SetDrawColorRGBA(renderer, 0xe0, 0x40, 0x40, 0xff);
+
+		CST_Rect bar = { xAbs + i * 2, graphBottom - barHeight, 2, barHeight };
+		CST_FillRect(renderer, &bar);
+	}
+
+	const RenderStats& s = lastStats;
+	int textX = xAbs + 5, textY = graphBottom + 4;
+	CST_DrawFont(font, renderer, textX, textY, "%.1f fps  %.2f ms", fps, lastRenderTime);
+	CST_DrawFont(font, renderer, textX, textY + 16, "visited %d  culled %d", s.visited, s.culled);
+	CST_DrawFont(font, renderer, textX, textY + 32, "draws %d  binds %d", s.drawCalls, s.textureBinds);
+	CST_DrawFont(font, renderer, textX, textY + 48, "gfx %d  text %d", s.gfxCalls, s.textRasterizations);
+}
+
+} // namespace Chesto
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Element.hpp"
+
+namespace Chesto {
+
+/// how many past frames are kept for the frame time graph
+#define PERF_HISTORY 120
+
+/// counters for the work done while drawing a single frame
+struct RenderStats
+{
+	int visited = 0;            // elements that had render called
+	int culled = 0;             // elements skipped for being offscreen
+	int drawCalls = 0;          // calls actually sent to SDL
+	int textureBinds = 0;       // draw calls that used a different texture than the last one
+	int gfxCalls = 0;           // SDL2_gfx primitives (circles, rounded boxes, etc)
+	int textRasterizations = 0; // TextElements that had to render their text to a new texture
+};
+
+/**
+ * A heads up display showing the FPS, a graph of recent frame times, and the render counters
+ * for the last frame. It's drawn over everything by RootDisplay whenever RootDisplay::isDebug is set.
+ */
+class PerfOverlay : public Element
+{
+public:
+	PerfOverlay();
+	~PerfOverlay();
+
+	void render(Element* parent);
+
+	/// reset the counters at the start of a frame
+	static void beginFrame();
+
+	/// save the counters and timings of the frame that was just drawn
+	static void endFrame();
+
+	/// counters for the frame currently being drawn
+	static RenderStats stats;
+
+	/// counters for the last finished frame
+	static RenderStats lastStats;
+
+private:
+	// time between the last few presented frames, in ms
+	static float frameTimes[PERF_HISTORY];
+	static int frameIndex;
+
+	// when the current frame started, and when the last one finished
+	static double frameStart;
+	static double lastFrameEnd;
+
+	// how long the last frame took to process and draw (not including waiting for the next one)
+	static float lastRenderTime;
+
+	CST_Font* font = NULL;
+};
+
+} // namespace Chesto
@@ -0,0 +1,159 @@
+#include "RedrawTrace.hpp"
+#include "Element.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <typeinfo>
+#include <unordered_set>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace Chesto {
+
+std::vector<RedrawCause> RedrawTrace::current;
+std::vector<RedrawCause> RedrawTrace::last;
+std::unordered_map<std::string, int> RedrawTrace::counts;
+
+// a readable class name, without the namespace
+static std::string typeName(const Element* element)
+{
+	const char* mangled = typeid(*element).name();
+	std::string name = mangled;
+
+#ifdef __GNUG__
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(mangled, NULL, NULL, &status);
+	if (status == 0 && demangled)
+		name = demangled;
+	free(demangled);
+#endif
+
+	size_t separator = name.rfind("::");
+	if (separator != std::string::npos)
+		name = name.substr(separator + 2);
+	return name;
+}
+
+void RedrawTrace::add(const Element* element, int reason)
+{
+	if (!element)
+	{
+		current.push_back({ NULL, "", 0, reason });
+		return;
+	}
+
+	current.push_back({ element, typeName(element), element->tag, reason });
+}
+
+size_t RedrawTrace::count()
+{
+	return current.size();
+}
+
+void RedrawTrace::beginFrame()
+{
+	current.clear();
+}
+
+void RedrawTrace::endFrame(bool drawn)
+{
+	if (!drawn)
+		return;
+
+	// every event in a frame is processed, so the same element can come up several times for the same reason
+	last.clear();
+	std::set<std::pair<const Element*, int>> seenCauses;
+	for (auto& cause : current)
+	{
+		if (!seenCauses.insert({ cause.element, cause.reason }).second)
+			continue;
+
+		last.push_back(cause);
+
+#ifdef CHESTO_TRACE
+		Trace::addEvent("redraw cause", describe(cause), Trace::now(), 0);
+#endif
+	}
+	current.clear();
+
+	// the totals are by description, so similar elements (like untagged TextElements) are counted together,
+	// but still only once per frame
+	std::unordered_set<std::string> seenDescriptions;
+	for (auto& cause : last)
+	{
+		std::string description = describe(cause);
+		if (seenDescriptions.insert(description).second)
+			counts[description]++;
+	}
+}
+
+const std::vector<RedrawCause>& RedrawTrace::lastFrame()
+{
+	return last;
+}
+
+const std::unordered_map<std::string, int>& RedrawTrace::totals()
+{
+	return counts;
+}
+
+void RedrawTrace::printTotals()
+{
+	std::vector<std::pair<std::string, int>> sorted(counts.begin(), counts.end());
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, int>& a, const std::pair<std::string, int>& b) {
+		return a.second > b.second;
+	});
+
+	printf("[RedrawTrace] Drawn frames caused by:\n");
+	for (auto& entry : sorted)
+		printf("%8d  %s\n", entry.second, entry.first.c_str());
+}
+
+void RedrawTrace::reset()
+{
+	counts.clear();
+	last.clear();
+}
+
+std::string RedrawTrace::describe(const RedrawCause& cause)
+{
+	if (!cause.element)
+		return reasonName(cause.reason);
+
+	std::string description = cause.type;
+	if (cause.tag != 0)
+		description += " (tag " + std::to_string(cause.tag) + ")";
+	return description + ": " + reasonName(cause.reason);
+}
+
+const char* RedrawTrace::reasonName(int reason)
+{
+	switch (reason)
+	{
+	case REDRAW_NEEDS_REDRAW:
+		return "needsRedraw";
+	case REDRAW_FUTURE_COUNTER:
+		return "futureRedrawCounter";
+	case REDRAW_ELASTIC_COUNTER:
+		return "elasticCounter";
+	case REDRAW_TOUCH:
+		return "touch";
+	case REDRAW_PROCESS:
+		return "process";
+	case REDRAW_POINTER_DRAG:
+		return "pointer drag";
+	case REDRAW_DAMAGE:
+		return "damage";
+	case REDRAW_TWEEN:
+		return "tween";
+	default:
+		return "unknown";
+	}
+}
+
+} // namespace Chesto
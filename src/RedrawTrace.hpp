@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Chesto {
+
+class Element;
+
+// why an element caused a frame to be drawn
+#define REDRAW_NEEDS_REDRAW 0    // its needsRedraw was set
+#define REDRAW_FUTURE_COUNTER 1  // it has futureRedrawCounter frames left
+#define REDRAW_ELASTIC_COUNTER 2 // its elasticCounter is pulsing (RootDisplay::idleCursorPulsing)
+#define REDRAW_TOUCH 3           // its touch handlers changed its highlight or drag state
+#define REDRAW_PROCESS 4         // its process() override returned true
+#define REDRAW_POINTER_DRAG 5    // the pointer is being dragged, which always redraws
+#define REDRAW_DAMAGE 6          // a region was damaged without any element asking for a redraw
+#define REDRAW_TWEEN 7           // an animation on the AnimationTimeline changed it
+
+struct RedrawCause
+{
+	const Element* element; // may already be gone, so only use it for comparisons
+	std::string type;       // the element's class name
+	int tag;
+	int reason;
+};
+
+/**
+ * When RootDisplay::traceRedraws is set, every element whose process() made the frame redraw is recorded
+ * along with why, so that redraws which don't visibly change anything can be tracked down.
+ * The causes of the last drawn frame, and totals over every drawn frame, can be read from here.
+ * In trace builds, they're also written to the trace as "redraw cause" events.
+ */
+class RedrawTrace
+{
+public:
+	/// record that an element caused a redraw (called by Element::process)
+	static void add(const Element* element, int reason);
+
+	/// how many causes have been recorded this frame so far
+	static size_t count();
+
+	/// start collecting the causes for a new frame
+	static void beginFrame();
+
+	/// finish the frame, keeping its causes if it was drawn
+	static void endFrame(bool drawn);
+
+	/// the causes of the last frame that was drawn, with each element and reason only once (even if it was
+	/// seen by several events)
+	static const std::vector<RedrawCause>& lastFrame();
+
+	/// the number of drawn frames each cause (by describe) was part of
+	static const std::unordered_map<std::string, int>& totals();
+
+	/// print the totals, most frequent first
+	static void printTotals();
+
+	/// forget the totals
+	static void reset();
+
+	/// something like "Button (tag 3): needsRedraw"
+	static std::string describe(const RedrawCause& cause);
+
+	static const char* reasonName(int reason);
+
+private:
+	static std::vector<RedrawCause> current;
+	static std::vector<RedrawCause> last;
+	static std::unordered_map<std::string, int> counts;
+};
+
+} // namespace Chesto
@@ -24,7 +24,18 @@
 #include "DownloadQueue.hpp"
 #include "Button.hpp"
 #include "TextElement.hpp"
+#include "DisplayList.hpp"
+#include "Scheduler.hpp"
+#include "Clock.hpp"
+#include "InputRecorder.hpp"
+#include "Trace.hpp"
+#include "PerfOverlay.hpp"
+#include "TouchIndex.hpp"
+#include "FocusManager.hpp"
+#include "ConstraintGraph.hpp"
+#include "RedrawTrace.hpp"
 #include <vector>
+#include <algorithm>
 
 namespace Chesto {
 
@@ -44,6 +55,26 @@ float RootDisplay::globalScale = 1.0f;
 
 bool RootDisplay::idleCursorPulsing = false;
 
+bool RootDisplay::partialRedraw = false;
+bool RootDisplay::showDamage = false;
+bool RootDisplay::retainedRender = false;
+bool RootDisplay::batchRendering = false;
+bool RootDisplay::indexTouches = false;
+bool RootDisplay::focusDispatch = false;
+bool RootDisplay::cullSubtrees = false;
+bool RootDisplay::cacheLayout = false;
+bool RootDisplay::cacheCoveredScreens = false;
+bool RootDisplay::headless = false;
+bool RootDisplay::traceRedraws = false;
+int RootDisplay::layoutGeneration = 0;
+const CST_Rect* RootDisplay::currentDamage = NULL;
+int RootDisplay::damageSerial = 0;
+std::vector<CST_Rect> RootDisplay::damagedRects;
+bool RootDisplay::fullDamage = false;
+
+// past this many separate regions, just redraw their union
+#define MAX_DAMAGE_RECTS 8
+
 RootDisplay::RootDisplay()
 {
 	// initialize the romfs for switch/wiiu
@@ -53,6 +84,15 @@ RootDisplay::RootDisplay()
 	// initialize internal drawing library
 	CST_DrawInit(this);
 
+	// trace builds always record a trace, to the path in CHESTO_TRACE_FILE if it's set
+	TRACE_START(getenv("CHESTO_TRACE_FILE") ? getenv("CHESTO_TRACE_FILE") : "trace.json");
+
+	// record or replay input, if asked to by the environment
+	if (getenv("CHESTO_RECORD_INPUT"))
+		InputRecorder::startRecording(getenv("CHESTO_RECORD_INPUT"));
+	if (getenv("CHESTO_REPLAY_INPUT"))
+		InputRecorder::startReplay(getenv("CHESTO_REPLAY_INPUT"), getenv("CHESTO_REPLAY_FAST") != NULL);
+
 	this->x = 0;
 	this->y = 0;
 	this->width = SCREEN_WIDTH;
@@ -127,6 +167,13 @@ void RootDisplay::setScreenResolution(int width, int height)
 	// update the renderer, but respect the DPI scaling
 	CST_SetWindowSize(window, SCREEN_WIDTH / RootDisplay::dpiScale, SCREEN_HEIGHT / RootDisplay::dpiScale);
 
+	// constraints without a parent are relative to the screen
+	layoutGeneration++;
+
+	// the back buffer will be resized on the next render
+	addFullDamage();
+	DisplayList::invalidateAll();
+
 	RootDisplay::deferAction([]() {
 		// inform all screens of the resolution change
 		for (auto& screen : screenStack) {
@@ -143,6 +190,8 @@ void RootDisplay::pushScreen(std::unique_ptr<Screen> screen)
 	// PUSHes are not deferred! They go right onto the stack and render immediately
 	screenStack.push_back(std::move(screen));
 	if (mainDisplay) mainDisplay->needsRedraw = true;
+	addFullDamage();
+	DisplayList::invalidateAll();
 }
 
 void RootDisplay::popScreen()
@@ -153,6 +202,8 @@ void RootDisplay::popScreen()
 			if (!screenStack.empty()) {
 				screenStack.pop_back();
 				if (mainDisplay) mainDisplay->needsRedraw = true;
+				addFullDamage();
+				DisplayList::invalidateAll();
 			}
 		});
 	} else {
@@ -160,6 +211,8 @@ void RootDisplay::popScreen()
 		if (!screenStack.empty()) {
 			screenStack.pop_back();
 			if (mainDisplay) mainDisplay->needsRedraw = true;
+			addFullDamage();
+			DisplayList::invalidateAll();
 		}
 	}
 }
@@ -171,10 +224,14 @@ void RootDisplay::clearScreens()
 		deferAction([]() {
 			screenStack.clear();
 			if (mainDisplay) mainDisplay->needsRedraw = true;
+			addFullDamage();
+			DisplayList::invalidateAll();
 		});
 	} else {
 		screenStack.clear();
 		if (mainDisplay) mainDisplay->needsRedraw = true;
+		addFullDamage();
+		DisplayList::invalidateAll();
 	}
 }
 
@@ -186,9 +243,15 @@ void RootDisplay::deferAction(std::function<void()> action)
 
 void RootDisplay::processDeferredActions()
 {
+	TRACE_ZONE("processDeferredActions");
+
 	// Execute all deferred actions, on a copy
 	auto actionsToRun = std::move(deferredActions);
 	deferredActions.clear();
+
+	// deferred actions can change anything, so nothing recorded can be trusted afterwards
+	if (!actionsToRun.empty())
+		DisplayList::invalidateAll();
 	
 	for (auto& action : actionsToRun) {
 		if (action) {
@@ -209,10 +272,16 @@ bool RootDisplay::hasScreens()
 
 RootDisplay::~RootDisplay()
 {
+	TRACE_STOP();
+	InputRecorder::stopRecording();
+
 	// Clean up screens and root element children before destroying download queue
 	// This ensures NetImageElements can cancel downloads properly
 	screenStack.clear();
 	elements.clear();
+
+	if (backBuffer)
+		CST_DestroyTexture(backBuffer);
 	
 	// Now safe to destroy download queue
 	DownloadQueue::quit();
@@ -230,37 +299,367 @@ bool RootDisplay::process(InputEvents* event)
 	// (may be a mouse cursor or wiimote pointing and moving on the screen)
 
 	bool result = false;
+
+	// find out which elements are under the pointer, so only they need to handle this event
+	if (indexTouches && event->isTouch())
+		TouchIndex::beginEvent(event->xPos, event->yPos);
+
+	// only send key events down the paths to the focused element and listeners
+	Element* top = screenStack.empty() ? (Element*)this : screenStack.back().get();
+	bool routed = focusDispatch && FocusManager::beginEvent(top, event);
 	
+	size_t causes = traceRedraws ? RedrawTrace::count() : 0;
+	bool handled;
 	if (!screenStack.empty()) {
-		result = screenStack.back()->process(event) || event->isTouchDrag();
+		int damageSerial = RootDisplay::damageSerial;
+		handled = screenStack.back()->process(event);
+
+		// the screen changed something without saying where, so everything has to be redrawn
+		if (handled && damageSerial == RootDisplay::damageSerial)
+			addFullDamage();
+
+		if (traceRedraws && handled && RedrawTrace::count() == causes)
+			RedrawTrace::add(screenStack.back().get(), REDRAW_PROCESS);
 	} else {
 		// keep processing child elements
-		result = super::process(event) || event->isTouchDrag();
+		handled = super::process(event);
 	}
+	result = handled || event->isTouchDrag();
+
+	if (traceRedraws && !handled && result)
+		RedrawTrace::add(NULL, REDRAW_POINTER_DRAG);
+
+	if (routed)
+		FocusManager::endEvent();
 	
 	return result;
 }
 
 void RootDisplay::render(Element* parent)
-{	
-	// if we have a screen stack, render each screen as layers
-	if (!screenStack.empty())
+{
+	TRACE_ZONE("render");
+
+	// being recorded (by compileDisplayList), so just draw the layers
+	if (DisplayList::recording)
 	{
-		super::render(parent);
-		
-		for (const auto& screen : screenStack) {
-			screen->render(this);
+		renderLayers(parent);
+		return;
+	}
+
+	// bring the recorded draw commands up to date before anything gets drawn
+	if (retainedRender && parent == NULL)
+		updateDisplayList();
+
+	if (partialRedraw && parent == NULL)
+	{
+		// nothing changed onscreen, so keep showing the last presented frame
+		if (!hasDamage())
+			return;
+
+		if (renderDamage(parent)) {
+			this->update();
+			return;
 		}
-		
-		this->update();
+	}
+
+	// draw everything, and commit it to the screen
+	renderLayers(parent);
+	this->update();
+}
+
+// the parts of each rect that are not inside of the given one (at most 4 per rect)
+static std::vector<CST_Rect> subtractRect(const std::vector<CST_Rect>& rects, const CST_Rect& cut)
+{
+	std::vector<CST_Rect> result;
+	for (auto& r : rects)
+	{
+		if (!CST_HasIntersection(&r, &cut))
+		{
+			result.push_back(r);
+			continue;
+		}
+
+		int left = std::max(r.x, cut.x), right = std::min(r.x + r.w, cut.x + cut.w);
+		int top = std::max(r.y, cut.y), bottom = std::min(r.y + r.h, cut.y + cut.h);
+
+		// the full-width strips above and below the cut, then what's left on either side of it
+		if (top > r.y)
+			result.push_back({ r.x, r.y, r.w, top - r.y });
+		if (bottom < r.y + r.h)
+			result.push_back({ r.x, bottom, r.w, r.y + r.h - bottom });
+		if (left > r.x)
+			result.push_back({ r.x, top, left - r.x, bottom - top });
+		if (right < r.x + r.w)
+			result.push_back({ right, top, r.x + r.w - right, bottom - top });
+	}
+	return result;
+}
+
+int RootDisplay::firstVisibleScreen()
+{
+	// only the part of the screen being drawn needs to be covered
+	CST_Rect area = currentDamage ? *currentDamage : CST_Rect{ 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+	std::vector<CST_Rect> uncovered = { area };
+
+	for (int i = (int)screenStack.size() - 1; i >= 0; i--)
+	{
+		for (auto& opaque : screenStack[i]->getOpaqueRegions())
+			uncovered = subtractRect(uncovered, opaque);
+
+		if (uncovered.empty())
+			return i;
+	}
+
+	return -1;
+}
+
+void RootDisplay::renderLayers(Element* parent)
+{
+	// replay the recorded commands instead of walking the tree
+	if (retainedRender && parent == NULL && displayList && !DisplayList::recording)
+	{
+		displayList->replay(renderer, currentDamage);
 		return;
 	}
 
+	// anything under an opaque screen can't be seen, so it doesn't need to be drawn
+	int firstVisible = firstVisibleScreen();
+	PerfOverlay::stats.culled += std::max(firstVisible, 0);
+
 	// render the rest of the subelements
-	super::render(parent);
+	if (firstVisible < 0)
+		super::render(parent);
 
-	// commit everything to the screen
-	this->update();
+	// if we have a screen stack, render each screen as layers
+	for (size_t i = std::max(firstVisible, 0); i < screenStack.size(); i++) {
+		auto& screen = screenStack[i];
+
+		// screens under the top one don't get any input, so they can be drawn from a cached layer
+		bool isTop = screen.get() == topScreen();
+		if (!isTop && cacheCoveredScreens && !screen->cacheAsLayer && screen->renderCachedLayer(this))
+			continue;
+
+		// the top screen's layer won't be used again until something is pushed over it
+		if (isTop && !screen->cacheAsLayer && screen->layerTexture)
+			screen->releaseLayer();
+
+		renderChild(screen.get());
+	}
+}
+
+bool RootDisplay::coveredLayerDirty()
+{
+	if (!cacheCoveredScreens || screenStack.size() < 2)
+		return false;
+
+	for (size_t i = std::max(firstVisibleScreen(), 0); i < screenStack.size() - 1; i++)
+	{
+		if (screenStack[i]->layerTexture && screenStack[i]->layerDirty)
+			return true;
+	}
+
+	return false;
+}
+
+void RootDisplay::layoutVisible()
+{
+	TRACE_ZONE("layout");
+
+	// elements are positioned after everything they depend on, wherever it is in the tree
+	updateLayoutGraph();
+	layoutGraph->evaluate();
+}
+
+void RootDisplay::relayout(Element* changed)
+{
+	updateLayoutGraph();
+	layoutGraph->evaluateFrom(changed);
+}
+
+void RootDisplay::updateLayoutGraph()
+{
+	if (!layoutGraph)
+		layoutGraph = std::make_unique<ConstraintGraph>();
+
+	// each visible screen, along with the parent it's laid out in
+	std::vector<std::pair<Element*, Element*>> roots;
+	int firstVisible = firstVisibleScreen();
+	if (firstVisible < 0)
+		roots.push_back({ this, NULL });
+
+	for (size_t i = std::max(firstVisible, 0); i < screenStack.size(); i++)
+		roots.push_back({ screenStack[i].get(), this });
+
+	// only rebuilt if the tree or the visible screens changed
+	layoutGraph->update(roots);
+}
+
+void RootDisplay::updateDisplayList()
+{
+	// the root's list is only a concatenation of its children and screens, so it's always rebuilt,
+	// but anything that didn't change is appended from its existing recording
+	displayListDirty = true;
+	compileDisplayList(NULL);
+}
+
+bool RootDisplay::renderDamage(Element* parent)
+{
+	// (re)create the back buffer if we don't have one that matches the screen
+	if (!backBuffer || backBufferWidth != SCREEN_WIDTH || backBufferHeight != SCREEN_HEIGHT)
+	{
+		if (backBuffer)
+			CST_DestroyTexture(backBuffer);
+
+		backBuffer = CST_CreateTargetTexture(renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+		backBufferWidth = SCREEN_WIDTH;
+		backBufferHeight = SCREEN_HEIGHT;
+
+		// the back buffer is the whole frame, so it replaces what's onscreen instead of blending over it
+		if (backBuffer)
+			CST_SetTextureBlend(backBuffer, false);
+
+		// a new back buffer has nothing in it yet
+		fullDamage = true;
+	}
+
+	// this renderer can't draw to textures, so always redraw everything
+	if (!backBuffer)
+	{
+		damagedRects.clear();
+		fullDamage = false;
+		return false;
+	}
+
+	auto rects = mergeDamage();
+
+	// redraw each of the damaged regions into the back buffer, clipped to that region
+	CST_SetRenderTarget(renderer, backBuffer);
+	for (auto& rect : rects)
+	{
+		currentDamage = &rect;
+		CST_SetClipRect(renderer, &rect);
+		renderLayers(parent);
+	}
+	currentDamage = NULL;
+	CST_SetClipRect(renderer, NULL);
+	CST_SetRenderTarget(renderer, NULL);
+
+	// the back buffer is the full frame, copy it over
+	CST_RenderCopy(renderer, backBuffer, NULL, NULL);
+
+	if (showDamage)
+	{
+		// flash what we just redrew, in a different color every frame
+		CST_SetDrawBlend(renderer, true);
+		auto color = toCST(randomColor());
+		for (auto& rect : rects)
+		{
+			CST_SetDrawColorRGBA(renderer, color.r, color.g, color.b, 0x40);
+			CST_FillRect(renderer, &rect);
+			CST_SetDrawColorRGBA(renderer, color.r, color.g, color.b, 0xff);
+			CST_DrawRect(renderer, &rect);
+		}
+	}
+
+	return true;
+}
+
+void RootDisplay::addDamage(const CST_Rect& rect)
+{
+	if (!partialRedraw)
+		return;
+
+	damageSerial++;
+
+	if (fullDamage || rect.w <= 0 || rect.h <= 0)
+		return;
+
+	// if there are too many separate regions, collapse them together
+	if (damagedRects.size() >= MAX_DAMAGE_RECTS * 4)
+	{
+		auto merged = damagedRects[0];
+		for (auto& other : damagedRects)
+			CST_UnionRect(&merged, &other, &merged);
+		damagedRects.clear();
+		damagedRects.push_back(merged);
+	}
+
+	damagedRects.push_back(rect);
+}
+
+void RootDisplay::addFullDamage()
+{
+	if (!partialRedraw)
+		return;
+
+	damageSerial++;
+	fullDamage = true;
+	damagedRects.clear();
+}
+
+bool RootDisplay::hasDamage()
+{
+	return fullDamage || !damagedRects.empty();
+}
+
+std::vector<CST_Rect> RootDisplay::mergeDamage()
+{
+	CST_Rect screen = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+	std::vector<CST_Rect> rects;
+
+	if (fullDamage)
+	{
+		rects.push_back(screen);
+		fullDamage = false;
+		damagedRects.clear();
+		return rects;
+	}
+
+	// clip everything to the screen, dropping any regions that are fully offscreen
+	for (auto& rect : damagedRects)
+	{
+		if (!CST_HasIntersection(&rect, &screen))
+			continue;
+
+		int x1 = std::max(rect.x, 0);
+		int y1 = std::max(rect.y, 0);
+		int x2 = std::min(rect.x + rect.w, SCREEN_WIDTH);
+		int y2 = std::min(rect.y + rect.h, SCREEN_HEIGHT);
+		rects.push_back({ x1, y1, x2 - x1, y2 - y1 });
+	}
+	damagedRects.clear();
+
+	// merge any overlapping regions, until none overlap (so nothing is drawn twice)
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+		for (size_t i = 0; i < rects.size() && !merged; i++)
+		{
+			for (size_t j = i + 1; j < rects.size(); j++)
+			{
+				if (CST_HasIntersection(&rects[i], &rects[j]))
+				{
+					CST_UnionRect(&rects[i], &rects[j], &rects[i]);
+					rects.erase(rects.begin() + j);
+					merged = true;
+					break;
+				}
+			}
+		}
+	}
+
+	// each region is a full pass over the tree, so past a few of them redraw their union instead
+	if (rects.size() > MAX_DAMAGE_RECTS)
+	{
+		auto all = rects[0];
+		for (auto& rect : rects)
+			CST_UnionRect(&all, &rect, &all);
+		rects.clear();
+		rects.push_back(all);
+	}
+
+	return rects;
 }
 
 void RootDisplay::update()
@@ -275,6 +674,16 @@ void RootDisplay::update()
 	//  if (diff < 16)
 	//      return;
 
+	PerfOverlay::endFrame();
+
+	// the perf overlay goes on top of everything else, and isn't part of any partial redraw or display list
+	if (isDebug)
+	{
+		if (!perfOverlay)
+			perfOverlay = std::make_unique<PerfOverlay>();
+		perfOverlay->render(this);
+	}
+
 	CST_RenderPresent(this->renderer);
 	//  this->lastFrameTime = now;
 }
@@ -295,6 +704,97 @@ void RootDisplay::requestQuit()
 #endif
 }
 
+bool RootDisplay::runFrame()
+{
+	TRACE_ZONE("frame");
+
+	bool atLeastOneNewEvent = false;
+	bool viewChanged = false;
+
+	// counters start here, so ones from processing (like text rasterizations) are kept
+	PerfOverlay::beginFrame();
+
+	// a virtual clock moves forward by one frame
+	Clock::get()->beginFrame();
+	InputRecorder::beginFrame();
+	if (traceRedraws)
+		RedrawTrace::beginFrame();
+	int now = Clock::now();
+
+	// update download queue
+	bool downloading = DownloadQueue::downloadQueue->process();
+
+	// fire any timers that are due, which may change what's onscreen
+	bool timersFired = Scheduler::runDueTimers(now);
+
+	// advance every running animation once, before anything is processed or drawn
+	bool animating = AnimationTimeline::step(now);
+
+	// get any new input events
+	{
+		TRACE_ZONE("events");
+		while (events->update())
+		{
+			isProcessingEvents = true;
+
+			// process the inputs of the supplied event
+			viewChanged |= this->process(events.get());
+			atLeastOneNewEvent = true;
+
+			isProcessingEvents = false;
+
+			// if we see a minus, exit immediately!
+			if (this->canUseSelectToExit && events->pressed(SELECT_BUTTON)) {
+				requestQuit();
+			}
+		}
+
+		// one more event update if nothing changed or there were no previous events seen
+		// needed to non-input related processing that might update the screen to take place
+		if ((!atLeastOneNewEvent && !viewChanged))
+		{
+			isProcessingEvents = true;
+			events->update();
+			viewChanged |= this->process(events.get());
+			isProcessingEvents = false;
+		}
+	}
+
+	// Event processing done, so run any deferred actions
+	bool hadDeferredActions = !deferredActions.empty();
+	processDeferredActions();
+
+	// covered screens aren't processed, so something on them asking to redraw only shows up in their layer
+	if (coveredLayerDirty())
+	{
+		viewChanged = true;
+		addFullDamage();
+	}
+
+	// draw the display if we processed an event or the view (or some region still needs it)
+	drewLastFrame = viewChanged || hasDamage();
+	if (traceRedraws)
+	{
+		// damage left over (or added by timers or deferred actions) without an element asking to redraw
+		if (drewLastFrame && RedrawTrace::count() == 0)
+			RedrawTrace::add(NULL, REDRAW_DAMAGE);
+		RedrawTrace::endFrame(drewLastFrame);
+	}
+
+	if (drewLastFrame)
+	{
+		// bring every position up to date at once, so rendering only has to check them
+		if (cacheLayout)
+			layoutVisible();
+
+		this->render(NULL);
+	}
+
+	// anything still in progress needs the loop to keep running
+	return drewLastFrame || downloading || timersFired || animating || hadDeferredActions
+		|| !deferredActions.empty() || events->isHoldingDirection();
+}
+
 int RootDisplay::mainLoop()
 {
 #ifdef __WIIU__
@@ -317,55 +817,28 @@ int RootDisplay::mainLoop()
 
 	while (isAppRunning)
 	{
-		bool atLeastOneNewEvent = false;
-	bool viewChanged = false;
+		int frameStart = Clock::now();
+		bool needsAnotherFrame = runFrame();
 
-	int frameStart = CST_GetTicks();
+		if (!isAppRunning)
+			break;
 
-	// update download queue
-	DownloadQueue::downloadQueue->process();
+		// if we drew, then proceed immediately without waiting for smoother progress bars / scrolling
+		if (drewLastFrame)
+			continue;
 
-	// get any new input events
-	while (events->update())
-	{
-		isProcessingEvents = true;
-		
-		// process the inputs of the supplied event
-		viewChanged |= this->process(events.get());
-		atLeastOneNewEvent = true;
-		
-		isProcessingEvents = false;
-
-		// if we see a minus, exit immediately!
-		if (this->canUseSelectToExit && events->pressed(SELECT_BUTTON)) {
-			requestQuit();
-		}
-	}		// one more event update if nothing changed or there were no previous events seen
-		// needed to non-input related processing that might update the screen to take place
-		if ((!atLeastOneNewEvent && !viewChanged))
+		int now = Clock::now();
+		if (needsAnotherFrame)
 		{
-			isProcessingEvents = true;
-			events->update();
-			viewChanged |= this->process(events.get());
-			isProcessingEvents = false;
+			// downloads or held buttons need polling, so wait out the rest of this frame (or until input arrives)
+			int elapsed = std::max(now - frameStart, 0);
+			if (elapsed < 16)
+				Scheduler::waitForWork(now, 16 - elapsed);
 		}
-		
-		// Event processing done, so run any deferred actions
-		processDeferredActions();
-
-		// draw the display if we processed an event or the view
-		if (viewChanged)
-			this->render(NULL);
 		else
 		{
-			// delay for the remainder of the frame to keep up to 60fps
-			// (we only do this if we didn't draw to not waste energy
-			// if we did draw, then proceed immediately without waiting for smoother progress bars / scrolling)
-			int delayTime = (CST_GetTicks() - frameStart);
-			if (delayTime < 0)
-				delayTime = 0;
-			if (delayTime < 16)
-				CST_Delay(16 - delayTime);
+			// nothing is happening, so sleep until input, a timer, or a wakeup
+			Scheduler::waitForWork(now, Scheduler::maxIdleWait);
 		}
 	}
 
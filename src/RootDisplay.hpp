@@ -17,6 +17,8 @@
 namespace Chesto {
 
 class Screen;
+class PerfOverlay;
+class ConstraintGraph;
 
 #define SCREEN_WIDTH RootDisplay::screenWidth
 #define SCREEN_HEIGHT RootDisplay::screenHeight
@@ -33,6 +35,9 @@ public:
 	void update();
 	int mainLoop();
 
+	// process events, timers, and downloads, and draw if needed. returns false if the app is idle
+	bool runFrame();
+
 	void initMusic();
 	void startMusic();
 
@@ -78,9 +83,78 @@ public:
 	// TODO: enable or disable based on battery level or user preference
 	static bool idleCursorPulsing;
 
+	// if enabled, outlines every element and shows a performance overlay (see PerfOverlay)
 	static bool isDebug;
 	bool canUseSelectToExit = false;
 
+	// if enabled, only the regions of the screen that changed are redrawn, into a persistent
+	// back buffer. Elements report their changes via needsRedraw, movement, or markDamaged()
+	static bool partialRedraw;
+
+	// if enabled alongside partialRedraw, flashes a colored overlay over the damaged regions
+	static bool showDamage;
+
+	// report a region of the screen (in absolute coordinates) as needing a redraw
+	static void addDamage(const CST_Rect& rect);
+
+	// report that the entire screen needs to be redrawn
+	static void addFullDamage();
+
+	// whether there are any damaged regions waiting to be redrawn
+	static bool hasDamage();
+
+	// the region currently being redrawn, or NULL if the whole screen is being drawn
+	static const CST_Rect* currentDamage;
+
+	// increases every time damage is reported, used to detect changes that didn't report any
+	static int damageSerial;
+
+	// if enabled, the element tree is recorded into display lists which are replayed each frame
+	// instead of re-rendered. Only elements that reported a change (or moved) are recorded again
+	static bool retainedRender;
+
+	// if enabled, consecutive textures and fills that share the same state are batched together
+	// and drawn with a single SDL_RenderGeometry call (requires SDL 2.0.18+)
+	static bool batchRendering;
+
+	// if enabled, touchable elements are kept in a grid by their bounds (see TouchIndex), and pointer
+	// events are only handled by the ones under the pointer, or that are being dragged or highlighted
+	static bool indexTouches;
+
+	// if enabled, key and gamepad button events are only processed along the path to the focused
+	// element and any global listeners (see FocusManager), instead of by the whole tree
+	static bool focusDispatch;
+
+	// if enabled, each element remembers the area its whole subtree draws to, and subtrees that are
+	// offscreen (or outside the region being redrawn) are skipped when rendering and on idle events
+	static bool cullSubtrees;
+
+	// if enabled, elements only recalculate their position when something it depends on has changed
+	// (their own fields, their parent, or a constraint target), and positions are updated in one
+	// layout pass before each frame is drawn. Changes to a Constraint's fields need Element::invalidateLayout
+	static bool cacheLayout;
+
+	// if enabled, screens under the top of the stack (which don't get any input) are drawn from a cached
+	// layer (see Element::cacheAsLayer). Changes to elements on them need Element::requestRedraw or
+	// invalidateDisplayList, since they aren't processed
+	static bool cacheCoveredScreens;
+
+	// if enabled before the RootDisplay is created (or if the CHESTO_HEADLESS environment variable is set),
+	// nothing is shown: SDL's dummy video driver is used, and frames are drawn by the software renderer into
+	// an offscreen framebuffer without VSYNC. For running and timing the whole pipeline without a display
+	static bool headless;
+
+	// if enabled, every element whose process() makes a frame redraw is recorded along with the reason,
+	// see RedrawTrace for reading them back
+	static bool traceRedraws;
+
+	// increases when something changes that affects every element's layout (like the screen size)
+	static int layoutGeneration;
+
+	/// recalculate the position of an element and everything positioned from it, right away, in dependency
+	/// order (for example, after changing one of its Constraints directly)
+	void relayout(Element* changed);
+
 	int lastFrameTime = 99;
 	SDL_Event needsRender;
 
@@ -96,10 +170,51 @@ public:
 #endif
 
 private:
+	// render the root children and every screen in the stack
+	void renderLayers(Element* parent);
+
+	// the index of the lowest screen in the stack that isn't completely covered by the ones above it,
+	// or -1 if the root's own elements can be seen
+	int firstVisibleScreen();
+
+	// whether a visible screen under the top one has a cached layer that's out of date (for cacheCoveredScreens)
+	bool coveredLayerDirty();
+
+	// run the layout pass over everything that will be drawn this frame (for cacheLayout)
+	void layoutVisible();
+
+	// make sure the layout graph covers the screens that are currently visible
+	void updateLayoutGraph();
+
+	// re-record any out of date display lists, and combine them into the root's list
+	void updateDisplayList();
+
+	// redraw only the damaged regions into the back buffer, returns false if unsupported
+	bool renderDamage(Element* parent);
+
+	// combine overlapping damage into a small list of rects to redraw
+	static std::vector<CST_Rect> mergeDamage();
+
+	static std::vector<CST_Rect> damagedRects;
+	static bool fullDamage;
+
+	// FPS and render counters, shown when isDebug is set
+	std::unique_ptr<PerfOverlay> perfOverlay;
+
+	// the order elements are laid out in (for cacheLayout)
+	std::unique_ptr<ConstraintGraph> layoutGraph;
+
+	// persistent copy of the screen contents, so undamaged regions survive between frames
+	CST_Texture* backBuffer = NULL;
+	int backBufferWidth = 0, backBufferHeight = 0;
+
 	// these bools are managed by RootDisplay mainLoop, and should not be modified
 	// to break out. Instead, call requestQuit() which will update it if needed
 	bool hasRequestedQuit = false;
 	bool isAppRunning = true;
+
+	// whether the last runFrame() rendered anything
+	bool drewLastFrame = false;
 };
 
 } // namespace Chesto
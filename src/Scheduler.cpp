@@ -0,0 +1,175 @@
+#include "Scheduler.hpp"
+#include "Clock.hpp"
+#include "RootDisplay.hpp"
+
+#include <algorithm>
+
+namespace Chesto {
+
+std::vector<ScheduledTimer> Scheduler::wheel[WHEEL_SLOTS];
+std::vector<ScheduledTimer> Scheduler::running;
+int Scheduler::currentTick = -1;
+int Scheduler::nextId = 1;
+int Scheduler::frameRequest = -1;
+
+#if defined(__WIIU__) || defined(SWITCH) || defined(_3DS) || defined(WII)
+// the system event loops on consoles are serviced while pumping SDL events, so don't block for too long
+int Scheduler::maxIdleWait = 100;
+#else
+int Scheduler::maxIdleWait = -1;
+#endif
+
+int Scheduler::addTimer(int delay, std::function<void()> callback, bool repeat)
+{
+	ScheduledTimer timer;
+	timer.id = nextId++;
+	timer.deadline = Clock::now() + std::max(delay, 0);
+	timer.interval = repeat ? std::max(delay, 1) : 0;
+	timer.callback = callback;
+	insert(timer);
+
+	return timer.id;
+}
+
+void Scheduler::insert(ScheduledTimer timer)
+{
+	// timers are hashed into the slot for their deadline, later rotations included
+	int slot = (timer.deadline / WHEEL_TICK_MS) % WHEEL_SLOTS;
+	wheel[slot].push_back(std::move(timer));
+}
+
+void Scheduler::cancelTimer(int id)
+{
+	for (auto& slot : wheel)
+	{
+		auto it = std::find_if(slot.begin(), slot.end(), [id](const ScheduledTimer& t) { return t.id == id; });
+		if (it != slot.end())
+		{
+			slot.erase(it);
+			return;
+		}
+	}
+
+	// it may be in the middle of firing, in which case it just shouldn't repeat
+	for (auto& timer : running)
+	{
+		if (timer.id == id)
+			timer.callback = NULL;
+	}
+}
+
+void Scheduler::requestFrameIn(int ms)
+{
+	int deadline = Clock::now() + std::max(ms, 0);
+	if (frameRequest < 0 || deadline < frameRequest)
+		frameRequest = deadline;
+}
+
+void Scheduler::wakeUp()
+{
+	// an empty user event is enough to end SDL_WaitEventTimeout
+	if (RootDisplay::mainDisplay)
+		SDL_PushEvent(&RootDisplay::mainDisplay->needsRender);
+}
+
+bool Scheduler::runDueTimers(int now)
+{
+	bool ran = false;
+
+	if (frameRequest >= 0 && frameRequest <= now)
+	{
+		frameRequest = -1;
+		ran = true;
+	}
+
+	// visit every slot between the last check and now (or all of them, if it's been a full rotation)
+	int nowTick = now / WHEEL_TICK_MS;
+	if (currentTick < 0 || currentTick > nowTick)
+		currentTick = nowTick;
+	int ticks = std::min(nowTick - currentTick + 1, WHEEL_SLOTS);
+
+	running.clear();
+	for (int i = 0; i < ticks; i++)
+	{
+		auto& slot = wheel[(currentTick + i) % WHEEL_SLOTS];
+		for (size_t j = 0; j < slot.size();)
+		{
+			if (slot[j].deadline <= now)
+			{
+				running.push_back(std::move(slot[j]));
+				slot.erase(slot.begin() + j);
+			}
+			else
+				j++;
+		}
+	}
+	currentTick = nowTick;
+
+	// fire in deadline order, and re-insert repeating timers (unless they were cancelled while firing)
+	std::sort(running.begin(), running.end(), [](const ScheduledTimer& a, const ScheduledTimer& b) {
+		return a.deadline < b.deadline;
+	});
+	for (size_t i = 0; i < running.size(); i++)
+	{
+		auto callback = running[i].callback;
+		if (callback)
+			callback();
+		ran = true;
+
+		if (running[i].interval > 0 && running[i].callback)
+		{
+			ScheduledTimer timer = running[i];
+			timer.deadline = std::max(timer.deadline + timer.interval, now + 1);
+			insert(timer);
+		}
+	}
+	running.clear();
+
+	return ran;
+}
+
+int Scheduler::nextDeadline()
+{
+	int best = frameRequest;
+	int start = std::max(currentTick, 0);
+
+	for (int i = 0; i < WHEEL_SLOTS; i++)
+	{
+		for (auto& timer : wheel[(start + i) % WHEEL_SLOTS])
+		{
+			if (best < 0 || timer.deadline < best)
+				best = timer.deadline;
+		}
+
+		// every timer in a later slot is due after this slot ends
+		if (best >= 0 && best < (start + i + 1) * WHEEL_TICK_MS)
+			break;
+	}
+
+	return best;
+}
+
+void Scheduler::waitForWork(int now, int maxWait)
+{
+	int timeout = maxWait;
+
+	int deadline = nextDeadline();
+	if (deadline >= 0)
+	{
+		int untilDeadline = std::max(deadline - now, 0);
+		if (timeout < 0 || untilDeadline < timeout)
+			timeout = untilDeadline;
+	}
+
+	// a virtual clock can skip straight past the wait
+	if (timeout > 0 && Clock::get()->skip(timeout))
+		return;
+
+	// passing NULL leaves the event in the queue, for the next frame to process
+	if (timeout < 0)
+		SDL_WaitEvent(NULL);
+	else if (timeout > 0)
+		SDL_WaitEventTimeout(NULL, timeout);
+}
+
+} // namespace Chesto
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace Chesto {
+
+/// the length of one slot of the timer wheel, in ms (about one frame)
+#define WHEEL_TICK_MS 16
+
+/// how many slots the timer wheel has (one full rotation is ~1 second)
+#define WHEEL_SLOTS 64
+
+struct ScheduledTimer
+{
+	int id;
+	int deadline;
+	int interval; // 0 for one-shot timers
+	std::function<void()> callback;
+};
+
+/**
+ * The Scheduler keeps track of everything that can wake the main loop up while it's idle:
+ * timers (stored in a hashed timer wheel), explicit frame requests, and wakeups posted from other threads.
+ * The main loop blocks in SDL_WaitEventTimeout until the earliest of these, or until input arrives.
+ */
+class Scheduler
+{
+public:
+	/// call the given function after delay ms (and then every delay ms, if repeat is set), returns an id for cancelTimer
+	static int addTimer(int delay, std::function<void()> callback, bool repeat = false);
+
+	/// stop a timer from firing (does nothing if it already fired or was cancelled)
+	static void cancelTimer(int id);
+
+	/// make sure the main loop runs another frame within the given number of ms
+	static void requestFrameIn(int ms);
+
+	/// wake up the main loop as soon as possible (safe to call from other threads)
+	static void wakeUp();
+
+	/// run the callbacks of every timer that's due, returns true if any ran
+	static bool runDueTimers(int now);
+
+	/// the time of the earliest timer or frame request, or -1 if there isn't one
+	static int nextDeadline();
+
+	/// block until input arrives, a wakeup is posted, or the next deadline (or maxWait ms) passes
+	static void waitForWork(int now, int maxWait);
+
+	/// the longest to block for while idle (-1 means until something happens)
+	static int maxIdleWait;
+
+private:
+	static void insert(ScheduledTimer timer);
+
+	static std::vector<ScheduledTimer> wheel[WHEEL_SLOTS];
+	static std::vector<ScheduledTimer> running;
+	static int currentTick;
+	static int nextId;
+	static int frameRequest;
+};
+
+} // namespace Chesto
@@ -13,6 +13,44 @@ Screen::Screen()
 Screen::~Screen()
 {
 	// Base destructor - unique_ptr handles cleanup automatically
+	// (but our elements have to go before the arena they live in)
+	elements.clear();
+
+	// anything from the arena that was moved out of this screen is still using it, so the arena
+	// frees itself once they're gone
+	if (nodeArena)
+		nodeArena.release()->destroyWhenEmpty();
+}
+
+ElementArena* Screen::getArena()
+{
+	if (!useArena)
+		return Element::getArena();
+
+	if (!nodeArena)
+		nodeArena = std::make_unique<ElementArena>();
+
+	return nodeArena.get();
+}
+
+std::vector<CST_Rect> Screen::getOpaqueRegions()
+{
+	if (hidden)
+		return {};
+
+	if (!opaqueRegions.empty())
+	{
+		std::vector<CST_Rect> regions;
+		for (auto& rect : opaqueRegions)
+			regions.push_back({ xAbs + rect.x, yAbs + rect.y, rect.w, rect.h });
+		return regions;
+	}
+
+	// rounded corners or rotation leave parts of the bounds uncovered
+	if (hasBackground && backgroundOpacity == 0xff && cornerRadius == 0 && angle == 0)
+		return { getBounds() };
+
+	return {};
 }
 
 int Screen::getScreenWidth() const
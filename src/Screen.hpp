@@ -36,10 +36,29 @@ public:
 	 */
 	virtual void rebuildUI() = 0;
 
+	/**
+	 * The regions of the screen (in absolute coordinates) that this screen fully covers,
+	 * so that the screens beneath it don't need to be drawn there. By default, this is
+	 * the explicit opaqueRegions, or the screen's bounds if it has a fully opaque background.
+	 */
+	virtual std::vector<CST_Rect> getOpaqueRegions();
+
+	/// regions (relative to the screen's position) that are known to be drawn fully opaque
+	std::vector<CST_Rect> opaqueRegions;
+
+	/// if set, elements made with createNode anywhere in this screen are allocated from an arena owned by
+	/// the screen, whose memory is reused as a whole once they're all removed (like on every rebuildUI)
+	bool useArena = false;
+
+	ElementArena* getArena() override;
+
 protected:
 	// Helper to get full screen dimensions
 	int getScreenWidth() const;
 	int getScreenHeight() const;
+
+private:
+	std::unique_ptr<ElementArena> nodeArena;
 };
 
 } // namespace Chesto
@@ -1,5 +1,7 @@
 #include "TextElement.hpp"
 #include "RootDisplay.hpp"
+#include "Trace.hpp"
+#include "PerfOverlay.hpp"
 #include <fstream>
 #include <ctime>   // std::time
 #include <dirent.h> // for directory reading
@@ -179,6 +181,9 @@ void TextElement::update(bool forceUpdate)
 
 	if (!loadFromCache(key) || forceUpdate)
 	{
+		TRACE_ZONE_DETAIL("text rasterization", text);
+		PerfOverlay::stats.textRasterizations++;
+
 		int actualFont = textFont;
 		if (TextElement::useSimplifiedChineseFont && textFont == NORMAL) {
 			actualFont = SIMPLIFIED_CHINESE;
@@ -1,4 +1,6 @@
 #include "Texture.hpp"
+#include "Trace.hpp"
+#include "PerfOverlay.hpp"
 
 namespace Chesto {
 
@@ -56,6 +58,8 @@ bool Texture::loadFromSurface(CST_Surface *surface)
 	if (!surface)
 		return false;
 
+	TRACE_ZONE("texture upload");
+
 	// will default MainDisplay's renderer if we don't have one in this->renderer
 	CST_Renderer* renderer = getRenderer();
 
@@ -74,6 +78,7 @@ bool Texture::loadFromSurface(CST_Surface *surface)
 
 	// load texture
 	mTexture = texture;
+	invalidateDisplayList();
 
 	return true;
 }
@@ -87,6 +92,7 @@ bool Texture::loadFromCache(std::string &key)
 		mTexture = texData->texture;
 		texFirstPixel = texData->firstPixel;
 		CST_QueryTexture(mTexture, &texW, &texH);
+		invalidateDisplayList();
 		return true;
 	}
 
@@ -149,6 +155,12 @@ void Texture::render(Element* parent)
 	rect.h = (int)(this->height * effectiveScale);
 
 	if (CST_isRectOffscreen(&rect))
+	{
+		PerfOverlay::stats.culled++;
+		return;
+	}
+
+	if (!isInDamage())
 		return;
 
 	CST_Renderer* renderer = getRenderer();
@@ -197,13 +209,15 @@ void Texture::render(Element* parent)
 	if (angle != 0) {
 		// render the texture with a rotation
 		CST_SetQualityHint("best");
-		CST_RenderCopyRotate(renderer, mTexture, NULL, &rect, this->angle);
+		CST_RenderCopyRotate(renderer, mTexture, NULL, &rect, this->angle, opacity);
 	}
 	else if (useColorMask) {
 		// render the texture with a mask color (only can darken the texture)
-		SDL_SetTextureColorMod(mTexture, maskColor.r, maskColor.g, maskColor.b);
-		CST_RenderCopy(renderer, mTexture, NULL, &rect);
-		SDL_SetTextureColorMod(mTexture, 0xFF, 0xFF, 0xFF);
+		CST_RenderCopyTinted(renderer, mTexture, NULL, &rect, { maskColor.r, maskColor.g, maskColor.b, (Uint8)opacity });
+	}
+	else if (opacity != 0xff) {
+		// render the texture faded
+		CST_RenderCopyTinted(renderer, mTexture, NULL, &rect, { 0xff, 0xff, 0xff, (Uint8)opacity });
 	} else {
 		// render the texture normally
 		CST_RenderCopy(renderer, mTexture, NULL, &rect);
@@ -214,6 +228,7 @@ void Texture::resize(int w, int h)
 {
 	width = w;
 	height = h;
+	invalidateDisplayList();
 }
 
 Texture* Texture::setSize(int w, int h)
@@ -246,13 +261,13 @@ bool Texture::saveTo(std::string &path)
 		return false;
 	
 	// set the target texture
-	SDL_SetRenderTarget(getRenderer(), target);
+	CST_SetRenderTarget(getRenderer(), target);
 
 	// render the texture
 	SDL_RenderCopy(getRenderer(), mTexture, NULL, NULL);
 
 	// reset the target texture
-	SDL_SetRenderTarget(getRenderer(), NULL);
+	CST_SetRenderTarget(getRenderer(), NULL);
 
 
 	// save the surface to the path
@@ -269,6 +284,7 @@ void Texture::loadPath(std::string& path, bool forceReload) {
 	
 	if (forceReload || !loadFromCache(path))
 	{
+		TRACE_ZONE_DETAIL("texture load", path);
 		CST_Surface *surface = IMG_Load(path.c_str());
 		loadFromSurfaceSaveToCache(path, surface);
 		CST_FreeSurface(surface);
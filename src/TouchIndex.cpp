@@ -0,0 +1,85 @@
+#include "TouchIndex.hpp"
+#include "Element.hpp"
+
+#include <algorithm>
+
+namespace Chesto {
+
+int TouchIndex::eventSerial = 0;
+std::unordered_map<int, std::vector<Element*>> TouchIndex::cells;
+
+int TouchIndex::toCell(int pos)
+{
+	// round towards negative infinity, so that -1 isn't in the same cell as 0
+	int cell = pos >= 0 ? pos / TOUCH_CELL_SIZE : (pos - TOUCH_CELL_SIZE + 1) / TOUCH_CELL_SIZE;
+	return std::max(TOUCH_CELL_MIN, std::min(cell, TOUCH_CELL_MAX));
+}
+
+int TouchIndex::cellKey(int cx, int cy)
+{
+	return (cy - TOUCH_CELL_MIN) * (TOUCH_CELL_MAX - TOUCH_CELL_MIN + 1) + (cx - TOUCH_CELL_MIN);
+}
+
+void TouchIndex::update(Element* element, const CST_Rect& bounds)
+{
+	int x1 = toCell(bounds.x), y1 = toCell(bounds.y);
+	int x2 = toCell(bounds.x + bounds.w), y2 = toCell(bounds.y + bounds.h);
+
+	// nothing to do if it's still covering the same cells
+	auto& last = element->touchCells;
+	if (element->inTouchIndex && last.x == x1 && last.y == y1 && last.w == x2 && last.h == y2)
+		return;
+
+	remove(element);
+
+	for (int cy = y1; cy <= y2; cy++)
+	{
+		for (int cx = x1; cx <= x2; cx++)
+			cells[cellKey(cx, cy)].push_back(element);
+	}
+
+	element->touchCells = { x1, y1, x2, y2 };
+	element->inTouchIndex = true;
+}
+
+void TouchIndex::remove(Element* element)
+{
+	if (!element->inTouchIndex)
+		return;
+
+	auto& c = element->touchCells;
+	for (int cy = c.y; cy <= c.h; cy++)
+	{
+		for (int cx = c.x; cx <= c.w; cx++)
+		{
+			auto it = cells.find(cellKey(cx, cy));
+			if (it == cells.end())
+				continue;
+
+			// order within a cell doesn't matter, so swap with the last one to remove
+			auto& list = it->second;
+			auto pos = std::find(list.begin(), list.end(), element);
+			if (pos != list.end())
+			{
+				*pos = list.back();
+				list.pop_back();
+			}
+		}
+	}
+
+	element->inTouchIndex = false;
+}
+
+void TouchIndex::beginEvent(int x, int y)
+{
+	eventSerial++;
+
+	auto it = cells.find(cellKey(toCell(x), toCell(y)));
+	if (it == cells.end())
+		return;
+
+	for (Element* element : it->second)
+		element->touchCandidateSerial = eventSerial;
+}
+
+} // namespace Chesto
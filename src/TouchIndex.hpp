@@ -0,0 +1,46 @@
+#pragma once
+
+#include "DrawUtils.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace Chesto {
+
+class Element;
+
+/// size of each grid cell, in pixels
+#define TOUCH_CELL_SIZE 64
+
+/// cells beyond this range (in either direction) are clamped into the outermost ones
+#define TOUCH_CELL_MIN -32
+#define TOUCH_CELL_MAX 96
+
+/**
+ * A uniform grid of the onscreen bounds of every touchable element, so that pointer events
+ * only need to be handled by the elements under the pointer (see RootDisplay::indexTouches).
+ * Elements add and update themselves when their position is calculated, and remove themselves when destroyed.
+ */
+class TouchIndex
+{
+public:
+	/// add or move an element to the given bounds
+	static void update(Element* element, const CST_Rect& bounds);
+
+	/// remove an element from the index (does nothing if it isn't in it)
+	static void remove(Element* element);
+
+	/// start a new pointer event at the given position, marking every element under it as a candidate
+	static void beginEvent(int x, int y);
+
+	/// increases with every pointer event, elements that are candidates for the current one have this serial
+	static int eventSerial;
+
+private:
+	static int cellKey(int cx, int cy);
+	static int toCell(int pos);
+
+	static std::unordered_map<int, std::vector<Element*>> cells;
+};
+
+} // namespace Chesto
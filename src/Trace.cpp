@@ -0,0 +1,118 @@
+#include "Trace.hpp"
+
+#ifdef CHESTO_TRACE
+
+#include "DrawUtils.hpp"
+
+namespace Chesto {
+
+// events are buffered and written out in chunks of this many
+#define TRACE_FLUSH_COUNT 4096
+
+bool Trace::enabled = false;
+FILE* Trace::file = NULL;
+bool Trace::firstEvent = true;
+uint64_t Trace::startCounter = 0;
+std::vector<TraceEvent> Trace::events;
+
+void Trace::start(const char* path)
+{
+	if (enabled)
+		stop();
+
+	file = fopen(path, "w");
+	if (!file)
+	{
+		printf("[Chesto] Could not open trace file %s\n", path);
+		return;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	firstEvent = true;
+	startCounter = SDL_GetPerformanceCounter();
+	events.reserve(TRACE_FLUSH_COUNT);
+	enabled = true;
+}
+
+void Trace::stop()
+{
+	if (!enabled)
+		return;
+
+	flush();
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	file = NULL;
+	enabled = false;
+}
+
+uint64_t Trace::now()
+{
+	uint64_t elapsed = SDL_GetPerformanceCounter() - startCounter;
+	return elapsed * 1000000 / SDL_GetPerformanceFrequency();
+}
+
+void Trace::addEvent(const char* name, const std::string& detail, uint64_t start, uint64_t duration)
+{
+	if (!enabled)
+		return;
+
+	events.push_back({ name, detail, start, duration });
+	if (events.size() >= TRACE_FLUSH_COUNT)
+		flush();
+}
+
+// write a string with any characters that json doesn't allow escaped
+static void writeEscaped(FILE* file, const std::string& str)
+{
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			fprintf(file, "\\%c", c);
+		else if ((unsigned char)c < 0x20)
+			fprintf(file, "\\u%04x", c);
+		else
+			fputc(c, file);
+	}
+}
+
+void Trace::flush()
+{
+	for (auto& event : events)
+	{
+		fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"chesto\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%llu,\"dur\":%llu",
+			firstEvent ? "" : ",\n", event.name,
+			(unsigned long long)event.start, (unsigned long long)event.duration);
+
+		if (!event.detail.empty())
+		{
+			fprintf(file, ",\"args\":{\"detail\":\"");
+			writeEscaped(file, event.detail);
+			fprintf(file, "\"}");
+		}
+
+		fprintf(file, "}");
+		firstEvent = false;
+	}
+
+	events.clear();
+	fflush(file);
+}
+
+TraceZone::TraceZone(const char* name, const std::string& detail)
+	: name(name)
+	, detail(Trace::enabled ? detail : "")
+	, start(Trace::enabled ? Trace::now() : 0)
+	, active(Trace::enabled)
+{
+}
+
+TraceZone::~TraceZone()
+{
+	if (active && Trace::enabled)
+		Trace::addEvent(name, detail, start, Trace::now() - start);
+}
+
+} // namespace Chesto
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+// Scoped trace zones, written out as Chrome trace-event JSON (open the file in chrome://tracing or ui.perfetto.dev)
+// These compile to nothing unless the build sets -DCHESTO_TRACE (make TRACE_BUILD=1)
+
+#ifdef CHESTO_TRACE
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/// time the rest of the current scope under the given name (must be a string literal)
+#define TRACE_ZONE(name) Chesto::TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+
+/// same as TRACE_ZONE, but also records a detail string (like a path or url) with the zone
+#define TRACE_ZONE_DETAIL(name, detail) Chesto::TraceZone TRACE_CONCAT(traceZone, __LINE__)(name, detail)
+
+/// start writing trace events to the given file
+#define TRACE_START(path) Chesto::Trace::start(path)
+
+/// finish and close the trace file
+#define TRACE_STOP() Chesto::Trace::stop()
+
+namespace Chesto {
+
+struct TraceEvent
+{
+	const char* name;
+	std::string detail;
+	uint64_t start; // in microseconds
+	uint64_t duration;
+};
+
+class Trace
+{
+public:
+	static void start(const char* path);
+	static void stop();
+
+	/// microseconds since tracing started
+	static uint64_t now();
+
+	static void addEvent(const char* name, const std::string& detail, uint64_t start, uint64_t duration);
+
+	static bool enabled;
+
+private:
+	/// write out the buffered events
+	static void flush();
+
+	static FILE* file;
+	static bool firstEvent;
+	static uint64_t startCounter;
+	static std::vector<TraceEvent> events;
+};
+
+class TraceZone
+{
+public:
+	TraceZone(const char* name, const std::string& detail = "");
+	~TraceZone();
+
+private:
+	const char* name;
+	std::string detail;
+	uint64_t start;
+	bool active; // whether tracing was on when the zone started
+};
+
+} // namespace Chesto
+
+#else
+
+#define TRACE_ZONE(name)
+#define TRACE_ZONE_DETAIL(name, detail)
+#define TRACE_START(path)
+#define TRACE_STOP()
+
+#endif